@@ -0,0 +1,578 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include "blockskiplist.h"
+#include "rng.h"
+
+/* Alignment of the blocks : a block starts on a cache line. */
+#define BLOCK_ALIGNMENT 64
+
+typedef struct s_Block Block;
+
+/* One level of a tower : links to the previous and next towers on this level.
+   width is the number of values in the towers from this one, included, to next, excluded. */
+typedef struct s_BlockLink{
+	Block* next;
+	Block* prev;
+	unsigned int width;
+} BlockLink;
+
+/* A tower : its sorted values first, to start on a cache line, then its height and one BlockLink per level.
+   The unused slots of keys hold INT_MAX, so that a scan of the whole block never counts them. */
+struct s_Block{
+	int keys[BLOCK_SKIPLIST_KEYS];
+	int nb_keys;
+	int level;
+	BlockLink link[];
+};
+
+/* The sentinel is a tower without values, before the first tower of each level. As in a SkipList, only the levels
+   [0, level) of the sentinel are linked. Linked towers are never empty. */
+struct s_BlockSkipList{
+	Block* sentinel;
+	int max_level;
+	int level;
+	bool adaptive;
+	unsigned int size;
+	unsigned int nb_blocks;
+	size_t bytes;
+	RNG rng;
+};
+
+/* Size of a tower of the given level, rounded up to a whole number of cache lines. */
+static size_t block_size(int level){
+	size_t size = sizeof(Block) + (size_t)level*sizeof(BlockLink);
+	return (size + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+}
+
+Block* block_alloc(BlockSkipList* d, int level){
+	void* memory;
+#ifdef _WIN32
+	memory = _aligned_malloc(block_size(level), BLOCK_ALIGNMENT);
+#else
+	if (posix_memalign(&memory, BLOCK_ALIGNMENT, block_size(level)) != 0){
+		memory = NULL;
+	}
+#endif
+	if (!memory){
+		fprintf(stderr, "Failed to allocated memory for a new block\n");
+		exit(1);
+	}
+	Block* block = memory;
+	block->nb_keys = 0;
+	block->level = level;
+	for (int k = 0; k < BLOCK_SKIPLIST_KEYS; k++){
+		block->keys[k] = INT_MAX;
+	}
+	d->bytes += block_size(level);
+	return block;
+}
+
+void block_free(BlockSkipList* d, Block* block){
+	d->bytes -= block_size(block->level);
+#ifdef _WIN32
+	_aligned_free(block);
+#else
+	free(block);
+#endif
+}
+
+/* Number of levels drawn for an adaptive list of the given number of blocks : 1 + floor(log2(nb_blocks+1)). */
+static int adaptive_levels(unsigned int nb_blocks){
+	int levels = 32 - __builtin_clz(nb_blocks + 1);
+	return levels < SKIPLIST_MAX_LEVEL ? levels : SKIPLIST_MAX_LEVEL;
+}
+
+/* Follow the number of blocks of an adaptive list with the bound of its random generator. */
+void block_update_height_bound(BlockSkipList* d){
+	if (d->adaptive){
+		rng_set_upper_bound(&d->rng, (unsigned int)adaptive_levels(d->nb_blocks));
+	}
+}
+
+Block* block_create(BlockSkipList* d, int level){
+	Block* block = block_alloc(d, level);
+	d->nb_blocks += 1;
+	block_update_height_bound(d);
+	return block;
+}
+
+BlockSkipList* block_skiplist_create(int nblevels){
+	bool adaptive = nblevels == 0;
+	if (adaptive){
+		nblevels = SKIPLIST_MAX_LEVEL;
+	}
+	BlockSkipList* l = malloc(sizeof(BlockSkipList));
+	if (!l){
+		fprintf(stderr, "Memory allocation failed for BlockSkiplist,\n");
+		exit(1);
+	}
+	l->bytes = 0;
+	l->sentinel = block_alloc(l, nblevels);
+	l->sentinel->link[0].next = l->sentinel;
+	l->sentinel->link[0].prev = l->sentinel;
+	l->sentinel->link[0].width = 0;
+	l->max_level = nblevels;
+	l->level = 1;
+	l->adaptive = adaptive;
+	l->size = 0;
+	l->nb_blocks = 0;
+	l->rng = rng_initialize_generator(0x7FFFFFFF, adaptive ? adaptive_levels(0) : nblevels, RNG_CTZ);
+	return l;
+}
+
+void block_skiplist_delete(BlockSkipList** d){
+	BlockSkipList* l = *d;
+	Block* block = l->sentinel->link[0].next;
+	while (block != l->sentinel){
+		Block* next_block = block->link[0].next;
+		block_free(l, block);
+		block = next_block;
+	}
+	block_free(l, l->sentinel);
+	free(l);
+	*d = NULL;
+}
+
+unsigned int block_skiplist_size(const BlockSkipList* d){
+	return d->size;
+}
+
+size_t block_skiplist_bytes(const BlockSkipList* d){
+	return sizeof(BlockSkipList) + d->bytes;
+}
+
+/* Number of values of the block lower than value. The whole block is scanned without branch, the unused slots
+   holding INT_MAX : the loop has a constant trip count and is vectorized by the compiler. */
+static int block_lower_bound(const Block* block, int value){
+	int count = 0;
+	for (int k = 0; k < BLOCK_SKIPLIST_KEYS; k++){
+		count += block->keys[k] < value;
+	}
+	return count;
+}
+
+/* Iterative top-down descent on the lowest values of the blocks.
+   Returns the last tower whose lowest value is lower than or equal to value, the sentinel if none, and, when update
+   is not NULL, stores in update[i] the last such tower on level i and in rank[i] the number of values before it.
+   Each tower compared to value counts as one operation. */
+Block* find_block(const BlockSkipList* d, int value, Block** update, unsigned int* rank, unsigned int* nb_operations){
+	Block* sentinel = d->sentinel;
+	Block* block = sentinel;
+	unsigned int pos = 0;
+	unsigned int operations = 0;
+	for (int level = d->level-1; level >= 0; --level){
+		Block* next = block->link[level].next;
+		while (next != sentinel){
+			++operations;
+			if (next->keys[0] > value){
+				break;
+			}
+			pos += block->link[level].width;
+			block = next;
+			next = block->link[level].next;
+		}
+		if (update){
+			update[level] = block;
+			rank[level] = pos;
+		}
+	}
+	*nb_operations += operations;
+	return block;
+}
+
+/* Open the levels [d->level, level) of the sentinel, empty so far, before binding a tower of the given level. */
+void block_raise_level(BlockSkipList* d, int level, Block** update, unsigned int* rank){
+	Block* sentinel = d->sentinel;
+	for (int i = d->level; i < level; i++){
+		sentinel->link[i].next = sentinel;
+		sentinel->link[i].prev = sentinel;
+		sentinel->link[i].width = d->size;
+		update[i] = sentinel;
+		rank[i] = 0;
+	}
+	if (level > d->level){
+		d->level = level;
+	}
+}
+
+/* Close the top levels left empty by a removal. */
+void block_lower_level(BlockSkipList* d){
+	while (d->level > 1 && d->sentinel->link[d->level-1].next == d->sentinel){
+		d->level -= 1;
+	}
+}
+
+/* Bind a tower whose pos values are preceded by pos values of the list, after the towers stored in update.
+   The values of the tower are already counted in the width of these towers. */
+void link_block(BlockSkipList* d, Block* block, Block** update, unsigned int* rank, unsigned int pos){
+	block_raise_level(d, block->level, update, rank);
+	for (int i = 0; i < block->level; i++){
+		Block* prev_block = update[i];
+		Block* next_block = prev_block->link[i].next;
+		block->link[i].width = prev_block->link[i].width - (pos - rank[i]);
+		prev_block->link[i].width = pos - rank[i];
+		block->link[i].prev = prev_block;
+		block->link[i].next = next_block;
+		prev_block->link[i].next = block;
+		next_block->link[i].prev = block;
+	}
+}
+
+/* Unbind and free a tower, its remaining values being counted from then on by its predecessors. */
+void unlink_block(BlockSkipList* d, Block* block){
+	for (int i = 0; i < block->level; i++){
+		Block* prev_block = block->link[i].prev;
+		Block* next_block = block->link[i].next;
+		prev_block->link[i].width += block->link[i].width;
+		prev_block->link[i].next = next_block;
+		next_block->link[i].prev = prev_block;
+	}
+	block_free(d, block);
+	d->nb_blocks -= 1;
+	block_lower_level(d);
+	block_update_height_bound(d);
+}
+
+/* Make block, preceded by pos values, the predecessor on its levels of the value to insert or remove. */
+void enter_block(Block* block, unsigned int pos, Block** update, unsigned int* rank){
+	for (int i = 0; i < block->level; i++){
+		update[i] = block;
+		rank[i] = pos;
+	}
+}
+
+/* Move the upper half of a full block into a new tower bound after it. update and rank hold the predecessors of block. */
+Block* split_block(BlockSkipList* d, Block* block, Block** update, unsigned int* rank){
+	Block* half = block_create(d, (int)rng_get_value(&d->rng) + 1);
+	int kept = block->nb_keys / 2;
+	half->nb_keys = block->nb_keys - kept;
+	memcpy(half->keys, &block->keys[kept], (size_t)half->nb_keys*sizeof(int));
+	for (int k = kept; k < block->nb_keys; k++){
+		block->keys[k] = INT_MAX;
+	}
+	block->nb_keys = kept;
+	link_block(d, half, update, rank, rank[0] + (unsigned int)kept);
+	return half;
+}
+
+BlockSkipList* block_skiplist_insert(BlockSkipList* d, int value){
+	Block* update[d->max_level];
+	unsigned int rank[d->max_level];
+	unsigned int nb_operations = 0;
+	Block* sentinel = d->sentinel;
+	Block* block = find_block(d, value, update, rank, &nb_operations);
+	int index = 0;
+	if (block != sentinel){
+		index = block_lower_bound(block, value);
+		// Case duplication : the block already holds the value
+		if (index < block->nb_keys && block->keys[index] == value){
+			return d;
+		}
+	}else if (sentinel->link[0].next != sentinel){
+		// value lower than all the values : it becomes the lowest value of the first block
+		block = sentinel->link[0].next;
+		enter_block(block, 0, update, rank);
+	}else{
+		block = block_create(d, (int)rng_get_value(&d->rng) + 1);
+		link_block(d, block, update, rank, 0);
+		enter_block(block, 0, update, rank);
+	}
+	if (block->nb_keys == BLOCK_SKIPLIST_KEYS){
+		Block* half = split_block(d, block, update, rank);
+		if (index > block->nb_keys){
+			index -= block->nb_keys;
+			enter_block(half, rank[0] + (unsigned int)block->nb_keys, update, rank);
+			block = half;
+		}
+	}
+	memmove(&block->keys[index+1], &block->keys[index], (size_t)(block->nb_keys - index)*sizeof(int));
+	block->keys[index] = value;
+	block->nb_keys += 1;
+	for (int i = 0; i < d->level; i++){
+		update[i]->link[i].width += 1;
+	}
+	d->size += 1;
+	return d;
+}
+
+BlockSkipList* block_skiplist_remove(BlockSkipList* d, int value){
+	Block* update[d->max_level];
+	unsigned int rank[d->max_level];
+	unsigned int nb_operations = 0;
+	Block* sentinel = d->sentinel;
+	Block* block = find_block(d, value, update, rank, &nb_operations);
+	if (block == sentinel){
+		return d;
+	}
+	int index = block_lower_bound(block, value);
+	if (index == block->nb_keys || block->keys[index] != value){
+		return d;
+	}
+	memmove(&block->keys[index], &block->keys[index+1], (size_t)(block->nb_keys - index - 1)*sizeof(int));
+	block->nb_keys -= 1;
+	block->keys[block->nb_keys] = INT_MAX;
+	for (int i = 0; i < d->level; i++){
+		update[i]->link[i].width -= 1;
+	}
+	d->size -= 1;
+	Block* next_block = block->link[0].next;
+	if (block->nb_keys == 0){
+		unlink_block(d, block);
+	}else if (block->nb_keys < BLOCK_SKIPLIST_KEYS/4 && next_block != sentinel
+			&& block->nb_keys + next_block->nb_keys <= BLOCK_SKIPLIST_KEYS/2){
+		// merge the successor into the block
+		memcpy(&block->keys[block->nb_keys], next_block->keys, (size_t)next_block->nb_keys*sizeof(int));
+		block->nb_keys += next_block->nb_keys;
+		unlink_block(d, next_block);
+	}
+	return d;
+}
+
+bool block_skiplist_search(const BlockSkipList* d, int value, unsigned int *nb_operations){
+	Block* block = find_block(d, value, NULL, NULL, nb_operations);
+	if (block == d->sentinel){
+		return false;
+	}
+	*nb_operations += 1;
+	int index = block_lower_bound(block, value);
+	return index < block->nb_keys && block->keys[index] == value;
+}
+
+int block_skiplist_at(const BlockSkipList* d, unsigned int i){
+	Block* sentinel = d->sentinel;
+	Block* block = sentinel;
+	unsigned int pos = 0;
+	// pos is the number of values before block
+	for (int level = d->level-1; level >= 0; --level){
+		while (block->link[level].next != sentinel && pos + block->link[level].width <= i){
+			pos += block->link[level].width;
+			block = block->link[level].next;
+		}
+	}
+	return block->keys[i - pos];
+}
+
+int block_skiplist_rank(const BlockSkipList* d, int value){
+	Block* update[d->max_level];
+	unsigned int rank[d->max_level];
+	unsigned int nb_operations = 0;
+	Block* block = find_block(d, value, update, rank, &nb_operations);
+	if (block == d->sentinel){
+		return -1;
+	}
+	int index = block_lower_bound(block, value);
+	if (index < block->nb_keys && block->keys[index] == value){
+		return (int)rank[0] + index;
+	}
+	return -1;
+}
+
+void block_skiplist_map(const BlockSkipList* d, ScanOperator f, void *user_data){
+	Block* sentinel = d->sentinel;
+	for (Block* block = sentinel->link[0].next; block != sentinel; block = block->link[0].next){
+		for (int k = 0; k < block->nb_keys; k++){
+			f(block->keys[k], user_data);
+		}
+	}
+}
+
+void block_skiplist_range_map(const BlockSkipList* d, int lo, int hi, ScanOperator f, void *user_data){
+	Block* sentinel = d->sentinel;
+	unsigned int nb_operations = 0;
+	Block* block = find_block(d, lo, NULL, NULL, &nb_operations);
+	int k = 0;
+	if (block == sentinel){
+		block = sentinel->link[0].next;
+	}else{
+		k = block_lower_bound(block, lo);
+	}
+	for (; block != sentinel; block = block->link[0].next, k = 0){
+		for (; k < block->nb_keys; k++){
+			if (block->keys[k] >= hi){
+				return;
+			}
+			f(block->keys[k], user_data);
+		}
+	}
+}
+
+void block_skiplist_map_batch(const BlockSkipList* d, BatchOperator f, void *user_data){
+	Block* sentinel = d->sentinel;
+	for (Block* block = sentinel->link[0].next; block != sentinel; block = block->link[0].next){
+		f(block->keys, (size_t)block->nb_keys, user_data);
+	}
+}
+
+void block_skiplist_aggregate_range(const BlockSkipList* d, int lo, int hi, KeyAggregate* aggregate){
+	if (lo >= hi){
+		return;
+	}
+	Block* sentinel = d->sentinel;
+	unsigned int nb_operations = 0;
+	Block* block = find_block(d, lo, NULL, NULL, &nb_operations);
+	int k = 0;
+	if (block == sentinel){
+		block = sentinel->link[0].next;
+	}else{
+		k = block_lower_bound(block, lo);
+	}
+	for (; block != sentinel; block = block->link[0].next, k = 0){
+		if (block->keys[block->nb_keys-1] < hi){
+			keys_aggregate(&block->keys[k], (size_t)(block->nb_keys - k), aggregate);
+		}else{
+			// last block of the range
+			size_t end = keys_lower_bound(block->keys, (size_t)block->nb_keys, hi);
+			keys_aggregate(&block->keys[k], end - (size_t)k, aggregate);
+			return;
+		}
+	}
+}
+
+static int compare_block_values(const void* a, const void* b){
+	int x = *(const int*)a;
+	int y = *(const int*)b;
+	return (x > y) - (x < y);
+}
+
+/* Link full blocks of the sorted values in one left to right pass, keeping the last tower of each level
+   and the number of values before it. */
+BlockSkipList* block_skiplist_build_from_array(const int* values, size_t n, int nblevels){
+	int* sorted = malloc((n ? n : 1)*sizeof(int));
+	if (!sorted){
+		fprintf(stderr, "Failed to allocated memory for sorting the values\n");
+		exit(1);
+	}
+	memcpy(sorted, values, n*sizeof(int));
+	qsort(sorted, n, sizeof(int), compare_block_values);
+	size_t m = 0;
+	for (size_t i = 0; i < n; i++){
+		if (m == 0 || sorted[m-1] != sorted[i]){
+			sorted[m++] = sorted[i];
+		}
+	}
+	BlockSkipList* d = block_skiplist_create(nblevels);
+	Block* sentinel = d->sentinel;
+	unsigned int nb_blocks = (unsigned int)((m + BLOCK_SKIPLIST_KEYS - 1) / BLOCK_SKIPLIST_KEYS);
+	int levels = d->adaptive ? adaptive_levels(nb_blocks) : d->max_level;
+	rng_set_upper_bound(&d->rng, (unsigned int)levels);
+	Block* tail[levels];
+	unsigned int tail_pos[levels];
+	for (int i = 0; i < levels; i++){
+		tail[i] = sentinel;
+		tail_pos[i] = 0;
+	}
+	for (size_t k = 0; k < m; k += BLOCK_SKIPLIST_KEYS){
+		unsigned int pos = (unsigned int)k;
+		Block* block = block_alloc(d, (int)rng_get_value(&d->rng) + 1);
+		block->nb_keys = m - k < BLOCK_SKIPLIST_KEYS ? (int)(m - k) : BLOCK_SKIPLIST_KEYS;
+		memcpy(block->keys, &sorted[k], (size_t)block->nb_keys*sizeof(int));
+		for (int i = 0; i < block->level; i++){
+			tail[i]->link[i].next = block;
+			tail[i]->link[i].width = pos - tail_pos[i];
+			block->link[i].prev = tail[i];
+			tail[i] = block;
+			tail_pos[i] = pos;
+		}
+	}
+	for (int i = 0; i < levels; i++){
+		tail[i]->link[i].next = sentinel;
+		tail[i]->link[i].width = (unsigned int)m - tail_pos[i];
+		sentinel->link[i].prev = tail[i];
+	}
+	d->level = levels;
+	d->size = (unsigned int)m;
+	d->nb_blocks = nb_blocks;
+	block_lower_level(d);
+	block_update_height_bound(d);
+	free(sorted);
+	return d;
+}
+
+/*-----BlockSkipList Iterator------*/
+struct s_BlockSkipListIterator{
+	BlockSkipList* collection;
+	Block* block;
+	int index;
+	IteratorDirection direction;
+};
+
+BlockSkipListIterator* block_skiplist_iterator_begin(BlockSkipListIterator* it){
+	Block* sentinel = it->collection->sentinel;
+	if (it->direction == FORWARD_ITERATOR){
+		it->block = sentinel->link[0].next;
+		it->index = 0;
+	}else{
+		it->block = sentinel->link[0].prev;
+		it->index = it->block->nb_keys - 1;
+	}
+	return it;
+}
+
+BlockSkipListIterator* block_skiplist_iterator_create(BlockSkipList* d, IteratorDirection direction){
+	BlockSkipListIterator* it = malloc(sizeof(BlockSkipListIterator));
+	if (!it){
+		fprintf(stderr, "Failed to allocated memory for an iterator\n");
+		exit(1);
+	}
+	it->collection = d;
+	it->direction = direction;
+	return block_skiplist_iterator_begin(it);
+}
+
+void block_skiplist_iterator_delete(BlockSkipListIterator** it){
+	free(*it);
+	*it = NULL;
+}
+
+bool block_skiplist_iterator_end(BlockSkipListIterator* it){
+	return it->block == it->collection->sentinel;
+}
+
+BlockSkipListIterator* block_skiplist_iterator_next(BlockSkipListIterator* it){
+	if (it->direction == FORWARD_ITERATOR){
+		if (++it->index == it->block->nb_keys){
+			it->block = it->block->link[0].next;
+			it->index = 0;
+		}
+	}else if (--it->index < 0){
+		it->block = it->block->link[0].prev;
+		it->index = it->block->nb_keys - 1;
+	}
+	return it;
+}
+
+BlockSkipListIterator* block_skiplist_iterator_seek(BlockSkipListIterator* it, int value){
+	BlockSkipList* l = it->collection;
+	unsigned int nb_operations = 0;
+	Block* block = find_block(l, value, NULL, NULL, &nb_operations);
+	if (block == l->sentinel){
+		// value lower than all the values
+		it->block = it->direction == FORWARD_ITERATOR ? block->link[0].next : block;
+		it->index = 0;
+		return it;
+	}
+	int index = block_lower_bound(block, value);
+	it->block = block;
+	if (it->direction == FORWARD_ITERATOR){
+		it->index = index;
+		if (index == block->nb_keys){
+			it->block = block->link[0].next;
+			it->index = 0;
+		}
+	}else{
+		// the lowest value of block is lower than or equal to value
+		it->index = index < block->nb_keys && block->keys[index] == value ? index : index - 1;
+	}
+	return it;
+}
+
+int block_skiplist_iterator_value(BlockSkipListIterator* it){
+	return it->block->keys[it->index];
+}
@@ -0,0 +1,244 @@
+#ifndef __BLOCKSKIPLIST_H__
+#define __BLOCKSKIPLIST_H__
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <stdio.h>
+
+#include "skiplist.h"
+
+/**
+ *	@defgroup BlockSkipListAT Block SkipList abstract type
+ *  @brief Definition of a SkipList type storing sorted blocks of values in its towers
+ *
+ *	Same operators as the SkipList abstract type. Each tower holds up to BLOCK_SKIPLIST_KEYS sorted values in
+ *	a cache line aligned block, and the towers are linked by the lowest value of their block : a search descends
+ *	the levels as in a SkipList, then scans one block without branch. Scans read the values block by block.
+ *	An insert into a full block splits it in two halves, a remove merges a block left less than a quarter full
+ *	with its successor when both fit in half a block.
+ *  @{
+ */
+
+/**
+ *	@brief Capacity of the block of a tower.
+ */
+#ifndef BLOCK_SKIPLIST_KEYS
+#define BLOCK_SKIPLIST_KEYS 32
+#endif
+
+/**
+ *	@brief Opaque definition of the BlockSkipList abstract data type.
+ */
+typedef struct s_BlockSkipList BlockSkipList;
+
+/**
+ *  @brief Constructor of an empty BlockSkipList.
+ *
+ * @par Profile
+ * @parblock
+ *	block_skiplist_create : int \f$\rightarrow\f$ BlockSkipList.
+ * @endparblock
+ *	@param nblevels the number of levels in the skip list, 0 to let the number of levels follow the number of blocks.
+ *  @return a correctly initialized BlockSkipList.
+ */
+BlockSkipList* block_skiplist_create(int nblevels);
+
+/**
+ *  @brief Constructor of a BlockSkipList holding the given values.
+ *
+ * @par Profile
+ * @parblock
+ *	block_skiplist_build_from_array : int* \f$\times\f$ size_t \f$\times\f$ int \f$\rightarrow\f$ BlockSkipList.
+ * @endparblock
+ *	@param values the values to store, in any order and possibly duplicated.
+ *	@param n the number of values.
+ *	@param nblevels the number of levels in the skip list, 0 to let the number of levels follow the number of blocks.
+ *  @return a BlockSkipList containing each value once, in full blocks.
+ */
+BlockSkipList* block_skiplist_build_from_array(const int* values, size_t n, int nblevels);
+
+/**
+ *  @brief Destructor of a BlockSkipList.
+ *
+ * @par Profile
+ * @parblock
+ *	block_skiplist_delete : BlockSkipList\f$\rightarrow \f$ void.
+ * @endparblock
+ *	@param d the skiplist to delete.
+ */
+void block_skiplist_delete(BlockSkipList** d);
+
+/**
+ *  @brief Access to the size the BlockSkipList.
+ *
+ *	@param d the BlockSkipList to access
+ *  @return the number of elements in the BlockSkipList.
+ */
+unsigned int block_skiplist_size(const BlockSkipList* d);
+
+/**
+ *  @brief Access to the \f$i^{th}\f$ element of the BlockSkipList.
+ *
+ *	@param d the BlockSkipList to access
+ *	@param i the index of the required value
+ *  @return the ith element of the BlockSkipList.
+ * @pre
+ *	0 \f$\le\f$  i \f$<\f$  block_skiplist_size(d)
+ *  @note runs in O(log n) using the number of values covered by each link.
+ */
+int block_skiplist_at(const BlockSkipList* d, unsigned int i);
+
+/**
+ *  @brief Position of a value in the BlockSkipList.
+ *
+ *	@param d the BlockSkipList to access
+ *	@param value the value to locate
+ *  @return the index i such that block_skiplist_at(d, i) = value, or -1 if the value is not in the BlockSkipList.
+ */
+int block_skiplist_rank(const BlockSkipList* d, int value);
+
+/**
+ *	@brief Insert the value v in the skip list d.
+
+ *	@param d the BlockSkipList to insert into
+ *	@param value the value to insert
+ *  @return the eventually modified skiplist.
+ *	@note inserting a value already in the list leaves the list unchanged.
+ */
+BlockSkipList* block_skiplist_insert(BlockSkipList* d, int value);
+
+/**
+ *	@brief Remove the value v from the skip list d.
+
+ *	@param d the BlockSkipList to remove from
+ *	@param value the value to remove
+ *  @return the eventually modified skiplist.
+ */
+BlockSkipList* block_skiplist_remove(BlockSkipList* d, int value);
+
+/**
+ *  @brief Search for the presence of a value in a BlockSkipList.
+ *
+ *	@param d the BlockSkipList to search into
+ *	@param value the value to search for
+ *	@param nb_operations The number of tested towers during the search, the scan of a block counting for one
+ *  @return true if the value was found, false otherwise.
+ */
+bool block_skiplist_search(const BlockSkipList* d, int value, unsigned int *nb_operations);
+
+/**
+ *  @brief Apply an operator on each member of the BlockSkipList, from the begining to the end.
+ *
+ *	@param d the BlockSkipList to access
+ *	@param f the operator to apply
+ *	@param environment user supplied environment for calling the operator.
+ */
+void block_skiplist_map(const BlockSkipList* d, ScanOperator f, void *environment);
+
+/**
+ *  @brief Apply an operator on each member of the BlockSkipList in [lo, hi), in ascending order.
+ *
+ *	@param d the BlockSkipList to access
+ *	@param lo the lowest value to visit
+ *	@param hi the strict upper bound of the values to visit
+ *	@param f the operator to apply
+ *	@param environment user supplied environment for calling the operator.
+ */
+void block_skiplist_range_map(const BlockSkipList* d, int lo, int hi, ScanOperator f, void *environment);
+
+/**
+ *  @brief Apply an operator on the members of the BlockSkipList block by block, from the begining to the end.
+ *
+ *	@param d the BlockSkipList to access
+ *	@param f the operator to apply, on the values of each block
+ *	@param environment user supplied environment for calling the operator.
+ *	@note the operator reads the values in place, without copy.
+ */
+void block_skiplist_map_batch(const BlockSkipList* d, BatchOperator f, void *environment);
+
+/**
+ *  @brief Aggregate of the members of the BlockSkipList in [lo, hi).
+ *
+ *	@param d the BlockSkipList to access
+ *	@param lo the lowest value to aggregate
+ *	@param hi the strict upper bound of the values to aggregate
+ *	@param aggregate the aggregate to update with the count, sum, min and max of these values
+ *	@note the blocks are aggregated in place by the vectorized kernel, after an O(log n) descent to lo.
+ */
+void block_skiplist_aggregate_range(const BlockSkipList* d, int lo, int hi, KeyAggregate* aggregate);
+
+/**
+ *  @brief Number of bytes allocated for the BlockSkipList and its blocks.
+ *
+ *	@param d the BlockSkipList to measure
+ *  @return the number of bytes.
+ */
+size_t block_skiplist_bytes(const BlockSkipList* d);
+
+/*-----------------------*/
+/* Iterator             */
+/*-----------------------*/
+
+/**
+ *	@brief Opaque definition of the BlockSkipListIterator abstract data type.
+ *
+ *	An iterator is invalidated by any insert or remove in its collection.
+ */
+typedef struct s_BlockSkipListIterator BlockSkipListIterator;
+
+/**
+ *	@brief Constructor of an iterator.
+ * @param d the BlockSkipList to iterate
+ * @param w the way the iterator will go (FORWARD_ITERATOR or BACKWARD_ITERATOR)
+ * @return the correcly initialized iterator
+ */
+BlockSkipListIterator* block_skiplist_iterator_create(BlockSkipList* d, IteratorDirection w);
+
+/**
+ *	@brief Destructor of an iterator.
+ *  @param it the iterator to delete
+ */
+void block_skiplist_iterator_delete(BlockSkipListIterator** it);
+
+/**
+ *	@brief Put the iterator at the beginning of its collection.
+ *  @param it the iterator to modify
+ *	@return the modified iterator
+ */
+BlockSkipListIterator* block_skiplist_iterator_begin(BlockSkipListIterator* it);
+
+/**
+ *	@brief Test if the iterator is at the end of its collection.
+ *  @param it the iterator to test
+ *  @return true if the iterator is at the end
+ */
+bool block_skiplist_iterator_end(BlockSkipListIterator* it);
+
+/**
+ *	@brief Increment the iterator to the next position according to its direction.
+ *  @param it the iterator to modify
+ *	@return the modified iterator
+ */
+BlockSkipListIterator* block_skiplist_iterator_next(BlockSkipListIterator* it);
+
+/**
+ *	@brief Put the iterator on a value of its collection.
+ *
+ *	A forward iterator is put on the first value greater than or equal to value,
+ *	a backward iterator on the last value lower than or equal to value.
+ *  @param it the iterator to modify
+ *  @param value the value to seek
+ *	@return the modified iterator, at the end of its collection if there is no such value
+ */
+BlockSkipListIterator* block_skiplist_iterator_seek(BlockSkipListIterator* it, int value);
+
+/**
+ *	@brief Acces to the value of the iterator.
+ *  @param it the iterator to access
+ *  @return the value designed by the iterator
+ */
+int block_skiplist_iterator_value(BlockSkipListIterator* it);
+
+/** @} */
+
+#endif
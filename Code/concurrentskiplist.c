@@ -0,0 +1,498 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "concurrentskiplist.h"
+#include "rng.h"
+
+/* Number of retired towers a thread accumulates before trying to advance the epoch and free them. */
+#define RECLAIM_THRESHOLD 64
+
+typedef struct s_CNode CNode;
+
+/* A tower of the concurrent list. next is read without lock, written with the lock of the tower held.
+   A tower is in the list once fully_linked is set and leaves it when marked is set. */
+struct s_CNode{
+	int value;
+	int node_level;
+	int lock;
+	int marked;
+	int fully_linked;
+	unsigned long retire_epoch;
+	CNode* retired_next;
+	CNode* next[];
+};
+
+/* Per thread state : epoch-based reclamation record, retired towers waiting to be freed and random generator.
+   owner, the identifier of the thread of the record, is set before the record is published. */
+typedef struct s_ThreadRecord ThreadRecord;
+struct s_ThreadRecord{
+	ThreadRecord* next;
+	pthread_t owner;
+	int active;
+	unsigned long epoch;
+	unsigned int depth;
+	CNode* retired_head;
+	CNode* retired_tail;
+	unsigned int nb_retired;
+	RNG rng;
+};
+
+struct s_ConcurrentSkipList{
+	CNode* head;
+	int max_level;
+	unsigned int size;
+	unsigned long epoch;
+	ThreadRecord* threads;
+	unsigned int nb_threads;
+	unsigned long long int id;
+};
+
+/* Record of the list a thread used last, found through a single thread key shared by every list : the number of
+   lists is not bounded by the number of thread keys. The identifier of a list is never reused, so a cached record
+   never belongs to a deleted list. */
+typedef struct s_ThreadCache{
+	unsigned long long int list;
+	ThreadRecord* record;
+} ThreadCache;
+
+static pthread_key_t thread_cache_key;
+static pthread_once_t thread_cache_created = PTHREAD_ONCE_INIT;
+static unsigned long long int last_list_id = 0;
+
+static size_t cnode_size(int level){
+	return sizeof(CNode) + (size_t)level*sizeof(CNode*);
+}
+
+CNode* cnode_create(int value, int level){
+	CNode* node = malloc(cnode_size(level));
+	if (!node){
+		fprintf(stderr, "Failed to allocated memory for a new node\n");
+		exit(1);
+	}
+	node->value = value;
+	node->node_level = level;
+	node->lock = 0;
+	node->marked = 0;
+	node->fully_linked = 0;
+	node->retired_next = NULL;
+	return node;
+}
+
+void cnode_lock(CNode* node){
+	while (__atomic_exchange_n(&node->lock, 1, __ATOMIC_ACQUIRE)){
+		while (__atomic_load_n(&node->lock, __ATOMIC_RELAXED)){
+			sched_yield();
+		}
+	}
+}
+
+void cnode_unlock(CNode* node){
+	__atomic_store_n(&node->lock, 0, __ATOMIC_RELEASE);
+}
+
+/*-----Epoch-based reclamation------*/
+
+static void thread_cache_create(void){
+	// the cache of a thread is freed when it ends, its records stay in the lists
+	if (pthread_key_create(&thread_cache_key, free)){
+		fprintf(stderr, "Failed to create the thread key of the Skiplists\n");
+		exit(1);
+	}
+}
+
+ThreadRecord* thread_record_create(ConcurrentSkipList* d, pthread_t owner){
+	ThreadRecord* r = calloc(1, sizeof(ThreadRecord));
+	if (!r){
+		fprintf(stderr, "Failed to allocated memory for a thread record\n");
+		exit(1);
+	}
+	r->owner = owner;
+	unsigned int index = __atomic_fetch_add(&d->nb_threads, 1, __ATOMIC_RELAXED);
+	r->rng = rng_initialize_generator(0x7FFFFFFF + index, (unsigned int)d->max_level, RNG_CTZ);
+	r->next = __atomic_load_n(&d->threads, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&d->threads, &r->next, r, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+	return r;
+}
+
+/* Record of the calling thread in d. The record of a thread that ended, and the towers it retired, are taken over by
+   the next thread given the same identifier. */
+ThreadRecord* thread_record(ConcurrentSkipList* d){
+	pthread_once(&thread_cache_created, thread_cache_create);
+	ThreadCache* cache = pthread_getspecific(thread_cache_key);
+	if (cache && cache->list == d->id){
+		return cache->record;
+	}
+	if (!cache){
+		cache = malloc(sizeof(ThreadCache));
+		if (!cache){
+			fprintf(stderr, "Failed to allocated memory for a thread cache\n");
+			exit(1);
+		}
+		pthread_setspecific(thread_cache_key, cache);
+	}
+	pthread_t self = pthread_self();
+	ThreadRecord* r = __atomic_load_n(&d->threads, __ATOMIC_ACQUIRE);
+	while (r && !pthread_equal(r->owner, self)){
+		r = r->next;
+	}
+	if (!r){
+		r = thread_record_create(d, self);
+	}
+	cache->list = d->id;
+	cache->record = r;
+	return r;
+}
+
+/* Enter a read-side critical section : towers reachable from now on are not freed before epoch_exit. */
+ThreadRecord* epoch_enter(ConcurrentSkipList* d){
+	ThreadRecord* r = thread_record(d);
+	if (r->depth++ == 0){
+		__atomic_store_n(&r->active, 1, __ATOMIC_SEQ_CST);
+		__atomic_store_n(&r->epoch, __atomic_load_n(&d->epoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+	}
+	return r;
+}
+
+void epoch_exit(ThreadRecord* r){
+	if (--r->depth == 0){
+		__atomic_store_n(&r->active, 0, __ATOMIC_RELEASE);
+	}
+}
+
+/* The global epoch moves forward once every thread inside a critical section has observed it. */
+void epoch_try_advance(ConcurrentSkipList* d){
+	unsigned long epoch = __atomic_load_n(&d->epoch, __ATOMIC_SEQ_CST);
+	for (ThreadRecord* r = __atomic_load_n(&d->threads, __ATOMIC_ACQUIRE); r; r = r->next){
+		if (__atomic_load_n(&r->active, __ATOMIC_SEQ_CST) && __atomic_load_n(&r->epoch, __ATOMIC_SEQ_CST) != epoch){
+			return;
+		}
+	}
+	__atomic_compare_exchange_n(&d->epoch, &epoch, epoch+1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+/* A tower unlinked during epoch e may still be read by threads that entered in e, never by those entering in e+2. */
+void epoch_reclaim(ConcurrentSkipList* d, ThreadRecord* r){
+	unsigned long epoch = __atomic_load_n(&d->epoch, __ATOMIC_SEQ_CST);
+	while (r->retired_head && r->retired_head->retire_epoch + 2 <= epoch){
+		CNode* node = r->retired_head;
+		r->retired_head = node->retired_next;
+		free(node);
+		r->nb_retired -= 1;
+	}
+	if (!r->retired_head){
+		r->retired_tail = NULL;
+	}
+}
+
+void epoch_retire(ConcurrentSkipList* d, ThreadRecord* r, CNode* node){
+	node->retire_epoch = __atomic_load_n(&d->epoch, __ATOMIC_SEQ_CST);
+	node->retired_next = NULL;
+	if (r->retired_tail){
+		r->retired_tail->retired_next = node;
+	}else{
+		r->retired_head = node;
+	}
+	r->retired_tail = node;
+	if (++r->nb_retired >= RECLAIM_THRESHOLD){
+		epoch_try_advance(d);
+		epoch_reclaim(d, r);
+	}
+}
+
+/*-----ConcurrentSkipList------*/
+
+ConcurrentSkipList* concurrent_skiplist_create(int nblevels){
+	ConcurrentSkipList* l = malloc(sizeof(ConcurrentSkipList));
+	if (!l){
+		fprintf(stderr, "Memory allocation failed for Skiplist,\n");
+		exit(1);
+	}
+	l->head = cnode_create(0, nblevels);
+	l->head->fully_linked = 1;
+	for (int i = 0; i < nblevels; i++){
+		l->head->next[i] = NULL;
+	}
+	l->max_level = nblevels;
+	l->size = 0;
+	l->epoch = 0;
+	l->threads = NULL;
+	l->nb_threads = 0;
+	l->id = __atomic_add_fetch(&last_list_id, 1, __ATOMIC_RELAXED);
+	return l;
+}
+
+void concurrent_skiplist_delete(ConcurrentSkipList** d){
+	ConcurrentSkipList* l = *d;
+	CNode* node = l->head;
+	while (node){
+		CNode* next_node = node->next[0];
+		free(node);
+		node = next_node;
+	}
+	ThreadRecord* r = l->threads;
+	while (r){
+		ThreadRecord* next_record = r->next;
+		while (r->retired_head){
+			CNode* retired = r->retired_head;
+			r->retired_head = retired->retired_next;
+			free(retired);
+		}
+		free(r);
+		r = next_record;
+	}
+	free(l);
+	*d = NULL;
+}
+
+unsigned int concurrent_skiplist_size(const ConcurrentSkipList* d){
+	return __atomic_load_n(&d->size, __ATOMIC_RELAXED);
+}
+
+bool cnode_is_member(CNode* node){
+	return __atomic_load_n(&node->fully_linked, __ATOMIC_ACQUIRE) && !__atomic_load_n(&node->marked, __ATOMIC_ACQUIRE);
+}
+
+/* Lock-free descent storing the predecessor and successor of value on each level.
+   Returns the highest level where the successor holds value, -1 if there is none. */
+int cfind(ConcurrentSkipList* d, int value, CNode** preds, CNode** succs, unsigned int *nb_operations){
+	int found_level = -1;
+	unsigned int operations = 0;
+	CNode* pred = d->head;
+	for (int level = d->max_level-1; level >= 0; --level){
+		CNode* curr = __atomic_load_n(&pred->next[level], __ATOMIC_ACQUIRE);
+		while (curr){
+			++operations;
+			if (curr->value >= value){
+				break;
+			}
+			pred = curr;
+			curr = __atomic_load_n(&pred->next[level], __ATOMIC_ACQUIRE);
+		}
+		if (found_level == -1 && curr && curr->value == value){
+			found_level = level;
+		}
+		preds[level] = pred;
+		succs[level] = curr;
+	}
+	*nb_operations += operations;
+	return found_level;
+}
+
+void unlock_preds(CNode** preds, int highest_locked){
+	CNode* prev_pred = NULL;
+	for (int level = 0; level <= highest_locked; level++){
+		if (preds[level] != prev_pred){
+			cnode_unlock(preds[level]);
+			prev_pred = preds[level];
+		}
+	}
+}
+
+/* Lock the predecessors of levels [0, top) from the bottom and check that each still links to succs[level].
+   The successors are required to be unmarked when inserting, not when unlinking a marked victim. */
+bool lock_preds(CNode** preds, CNode** succs, int top, bool unmarked_succs, int* highest_locked){
+	CNode* prev_pred = NULL;
+	bool valid = true;
+	*highest_locked = -1;
+	for (int level = 0; valid && level < top; level++){
+		CNode* pred = preds[level];
+		CNode* succ = succs[level];
+		if (pred != prev_pred){
+			cnode_lock(pred);
+			*highest_locked = level;
+			prev_pred = pred;
+		}
+		valid = !__atomic_load_n(&pred->marked, __ATOMIC_ACQUIRE)
+			&& (!unmarked_succs || succ == NULL || !__atomic_load_n(&succ->marked, __ATOMIC_ACQUIRE))
+			&& __atomic_load_n(&pred->next[level], __ATOMIC_ACQUIRE) == succ;
+	}
+	return valid;
+}
+
+ConcurrentSkipList* concurrent_skiplist_insert(ConcurrentSkipList* d, int value){
+	ThreadRecord* r = epoch_enter(d);
+	int top = (int)rng_get_value(&r->rng) + 1;
+	CNode* preds[d->max_level];
+	CNode* succs[d->max_level];
+	unsigned int nb_operations = 0;
+	while (true){
+		int found_level = cfind(d, value, preds, succs, &nb_operations);
+		if (found_level != -1){
+			CNode* found = succs[found_level];
+			if (!__atomic_load_n(&found->marked, __ATOMIC_ACQUIRE)){
+				// already there : wait for a concurrent insert of the same value to complete
+				while (!__atomic_load_n(&found->fully_linked, __ATOMIC_ACQUIRE)){
+					sched_yield();
+				}
+				break;
+			}
+			// being removed : retry once it is unlinked
+			continue;
+		}
+		int highest_locked;
+		if (!lock_preds(preds, succs, top, true, &highest_locked)){
+			unlock_preds(preds, highest_locked);
+			continue;
+		}
+		CNode* node = cnode_create(value, top);
+		for (int level = 0; level < top; level++){
+			node->next[level] = succs[level];
+		}
+		for (int level = 0; level < top; level++){
+			__atomic_store_n(&preds[level]->next[level], node, __ATOMIC_RELEASE);
+		}
+		__atomic_store_n(&node->fully_linked, 1, __ATOMIC_RELEASE);
+		unlock_preds(preds, highest_locked);
+		__atomic_fetch_add(&d->size, 1, __ATOMIC_RELAXED);
+		break;
+	}
+	epoch_exit(r);
+	return d;
+}
+
+ConcurrentSkipList* concurrent_skiplist_remove(ConcurrentSkipList* d, int value){
+	ThreadRecord* r = epoch_enter(d);
+	CNode* preds[d->max_level];
+	CNode* succs[d->max_level];
+	CNode* victim = NULL;
+	bool is_marked = false;
+	unsigned int nb_operations = 0;
+	while (true){
+		int found_level = cfind(d, value, preds, succs, &nb_operations);
+		if (!is_marked){
+			if (found_level == -1){
+				break;
+			}
+			victim = succs[found_level];
+			// only remove a completely inserted tower, found on its top level
+			if (!__atomic_load_n(&victim->fully_linked, __ATOMIC_ACQUIRE) || victim->node_level-1 != found_level
+				|| __atomic_load_n(&victim->marked, __ATOMIC_ACQUIRE)){
+				break;
+			}
+			cnode_lock(victim);
+			if (__atomic_load_n(&victim->marked, __ATOMIC_ACQUIRE)){
+				cnode_unlock(victim);
+				break;
+			}
+			__atomic_store_n(&victim->marked, 1, __ATOMIC_RELEASE);
+			is_marked = true;
+		}
+		int top = victim->node_level;
+		for (int level = 0; level < top; level++){
+			succs[level] = victim;
+		}
+		int highest_locked;
+		if (!lock_preds(preds, succs, top, false, &highest_locked)){
+			unlock_preds(preds, highest_locked);
+			continue;
+		}
+		for (int level = top-1; level >= 0; level--){
+			__atomic_store_n(&preds[level]->next[level], victim->next[level], __ATOMIC_RELEASE);
+		}
+		cnode_unlock(victim);
+		unlock_preds(preds, highest_locked);
+		__atomic_fetch_sub(&d->size, 1, __ATOMIC_RELAXED);
+		epoch_retire(d, r, victim);
+		break;
+	}
+	epoch_exit(r);
+	return d;
+}
+
+bool concurrent_skiplist_search(ConcurrentSkipList* d, int value, unsigned int *nb_operations){
+	ThreadRecord* r = epoch_enter(d);
+	unsigned int operations = 0;
+	CNode* pred = d->head;
+	CNode* curr = NULL;
+	for (int level = d->max_level-1; level >= 0; --level){
+		curr = __atomic_load_n(&pred->next[level], __ATOMIC_ACQUIRE);
+		while (curr){
+			++operations;
+			if (curr->value >= value){
+				break;
+			}
+			pred = curr;
+			curr = __atomic_load_n(&pred->next[level], __ATOMIC_ACQUIRE);
+		}
+	}
+	bool found = curr && curr->value == value && cnode_is_member(curr);
+	epoch_exit(r);
+	*nb_operations += operations;
+	return found;
+}
+
+int concurrent_skiplist_at(ConcurrentSkipList* d, unsigned int i){
+	ThreadRecord* r = epoch_enter(d);
+	CNode* node = __atomic_load_n(&d->head->next[0], __ATOMIC_ACQUIRE);
+	for (unsigned int pos = 0; node; node = __atomic_load_n(&node->next[0], __ATOMIC_ACQUIRE)){
+		if (cnode_is_member(node) && pos++ == i){
+			break;
+		}
+	}
+	int value = node ? node->value : 0;
+	epoch_exit(r);
+	return value;
+}
+
+void concurrent_skiplist_map(ConcurrentSkipList* d, ScanOperator f, void *user_data){
+	ThreadRecord* r = epoch_enter(d);
+	for (CNode* node = __atomic_load_n(&d->head->next[0], __ATOMIC_ACQUIRE); node; node = __atomic_load_n(&node->next[0], __ATOMIC_ACQUIRE)){
+		if (cnode_is_member(node)){
+			f(node->value, user_data);
+		}
+	}
+	epoch_exit(r);
+}
+
+/*-----ConcurrentSkipList Iterator------*/
+struct s_ConcurrentSkipListIterator{
+	ConcurrentSkipList* collection;
+	ThreadRecord* record;
+	CNode* current;
+};
+
+/* Move forward to the first tower of the list from node included. */
+CNode* first_member(CNode* node){
+	while (node && !cnode_is_member(node)){
+		node = __atomic_load_n(&node->next[0], __ATOMIC_ACQUIRE);
+	}
+	return node;
+}
+
+ConcurrentSkipListIterator* concurrent_skiplist_iterator_create(ConcurrentSkipList* d){
+	ConcurrentSkipListIterator* t = malloc(sizeof(ConcurrentSkipListIterator));
+	if (!t){
+		fprintf(stderr, "Failed to allocated memory for an iterator\n");
+		exit(1);
+	}
+	t->collection = d;
+	t->record = epoch_enter(d);
+	return concurrent_skiplist_iterator_begin(t);
+}
+
+void concurrent_skiplist_iterator_delete(ConcurrentSkipListIterator** it){
+	epoch_exit((*it)->record);
+	free(*it);
+	*it = NULL;
+}
+
+ConcurrentSkipListIterator* concurrent_skiplist_iterator_begin(ConcurrentSkipListIterator* it){
+	it->current = first_member(__atomic_load_n(&it->collection->head->next[0], __ATOMIC_ACQUIRE));
+	return it;
+}
+
+bool concurrent_skiplist_iterator_end(ConcurrentSkipListIterator* it){
+	return it->current == NULL;
+}
+
+ConcurrentSkipListIterator* concurrent_skiplist_iterator_next(ConcurrentSkipListIterator* it){
+	it->current = first_member(__atomic_load_n(&it->current->next[0], __ATOMIC_ACQUIRE));
+	return it;
+}
+
+int concurrent_skiplist_iterator_value(ConcurrentSkipListIterator* it){
+	return it->current->value;
+}
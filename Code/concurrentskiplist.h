@@ -0,0 +1,167 @@
+#ifndef __CONCURRENTSKIPLIST_H__
+#define __CONCURRENTSKIPLIST_H__
+#include <stdbool.h>
+
+#include <stdio.h>
+
+#include "skiplist.h"
+
+/**
+ *	@defgroup ConcurrentSkipListAT Concurrent SkipList abstract type
+ *  @brief Definition of a thread-safe SkipList type and operators
+ *
+ *	The core operators of the SkipList abstract type, callable from any number of threads at once : create, delete,
+ *	size, insert, remove, search, map, positional access and a forward iterator. There is no backward iterator,
+ *	no rank, range, batch or set operation, and the links hold no width : concurrent_skiplist_at runs in O(i).
+ *	Searches and iterations take no lock and never wait for a writer. Inserts and removes lock only the
+ *	predecessors of the modified tower, a removed tower being first marked as logically deleted then unlinked.
+ *	Removed towers are freed by epoch-based reclamation, once no thread may still be reading them.
+ *  @{
+ */
+
+/**
+ *	@brief Opaque definition of the ConcurrentSkipList abstract data type.
+ */
+typedef struct s_ConcurrentSkipList ConcurrentSkipList;
+
+/**
+ *  @brief Constructor of an empty ConcurrentSkipList.
+ *
+ * @par Profile
+ * @parblock
+ *	concurrent_skiplist_create : \f$\rightarrow\f$ ConcurrentSkipList.
+ * @endparblock
+ *	@param nblevels the number of levels in the skip list.
+ *  @return a correctly initialized ConcurrentSkipList.
+ */
+ConcurrentSkipList* concurrent_skiplist_create(int nblevels);
+
+/**
+ *  @brief Destructor of a ConcurrentSkipList.
+ *
+ * @par Profile
+ * @parblock
+ *	concurrent_skiplist_delete : ConcurrentSkipList\f$\rightarrow \f$ void.
+ * @endparblock
+ *	@param d the skiplist to delete.
+ *  @pre no other thread uses the list.
+ */
+void concurrent_skiplist_delete(ConcurrentSkipList** d);
+
+/**
+ *  @brief Access to the size the ConcurrentSkipList.
+ *
+ *	@param d the ConcurrentSkipList to access
+ *  @return the number of elements in the ConcurrentSkipList.
+ */
+unsigned int concurrent_skiplist_size(const ConcurrentSkipList* d);
+
+/**
+ *  @brief Access to the \f$i^{th}\f$ element of the ConcurrentSkipList.
+ *
+ *	@param d the ConcurrentSkipList to access
+ *	@param i the index of the required value
+ *  @return the ith element of the ConcurrentSkipList.
+ * @pre
+ *	0 \f$\le\f$  i \f$<\f$  concurrent_skiplist_size(d)
+ *  @note the links hold no width in this variant : the access walks level 0 in O(i).
+ */
+int concurrent_skiplist_at(ConcurrentSkipList* d, unsigned int i);
+
+/**
+ *	@brief Insert the value v in the skip list d.
+
+ *	@param d the ConcurrentSkipList to insert into
+ *	@param value the value to insert
+ *  @return the modified skiplist.
+ *	@note inserting a value already in the list leaves the list unchanged.
+ */
+ConcurrentSkipList* concurrent_skiplist_insert(ConcurrentSkipList* d, int value);
+
+/**
+ *	@brief Remove the value v from the skip list d.
+
+ *	@param d the ConcurrentSkipList to remove from
+ *	@param value the value to remove
+ *  @return the eventually modified skiplist.
+ */
+ConcurrentSkipList* concurrent_skiplist_remove(ConcurrentSkipList* d, int value);
+
+/**
+ *  @brief Search for the presence of a value in a ConcurrentSkipList.
+ *
+ *	@param d the ConcurrentSkipList to search into
+ *	@param value the value to search for
+ *	@param nb_operations The number of tested nodes during the search
+ *  @return true if the value was found, false otherwise.
+ *
+ */
+bool concurrent_skiplist_search(ConcurrentSkipList* d, int value, unsigned int *nb_operations);
+
+/**
+ *  @brief Apply an operator on each member of the ConcurrentSkipList, from the begining to the end.
+ *
+ *	@param d the ConcurrentSkipList to access
+ *	@param f the operator to apply
+ *	@param environment user supplied environment for calling the operator.
+ *  @note values inserted or removed during the scan may or may not be visited.
+ */
+void concurrent_skiplist_map(ConcurrentSkipList* d, ScanOperator f, void *environment);
+
+/*-----------------------*/
+/* Iterator             */
+/*-----------------------*/
+
+/**
+ *	@brief Opaque definition of the ConcurrentSkipListIterator abstract data type.
+ *
+ *	A living iterator keeps its thread inside a read-side critical section :
+ *	towers removed meanwhile are not freed before the iterator is deleted.
+ *	An iterator is used by the thread that created it.
+ */
+typedef struct s_ConcurrentSkipListIterator ConcurrentSkipListIterator;
+
+/**
+ *	@brief Constructor of a forward iterator.
+ * @param d the ConcurrentSkipList to iterate
+ * @return the correcly initialized iterator
+ */
+ConcurrentSkipListIterator* concurrent_skiplist_iterator_create(ConcurrentSkipList* d);
+
+/**
+ *	@brief Destructor of an iterator.
+ *  @param it the iterator to delete
+ */
+void concurrent_skiplist_iterator_delete(ConcurrentSkipListIterator** it);
+
+/**
+ *	@brief Put the iterator at the beginning of its collection.
+ *  @param it the iterator to modify
+ *	@return the modified iterator
+ */
+ConcurrentSkipListIterator* concurrent_skiplist_iterator_begin(ConcurrentSkipListIterator* it);
+
+/**
+ *	@brief Test if the iterator is at the end of its collection.
+ *  @param it the iterator to test
+ *  @return true if the iterator is at the end
+ */
+bool concurrent_skiplist_iterator_end(ConcurrentSkipListIterator* it);
+
+/**
+ *	@brief Increment the iterator to the next value of its collection.
+ *  @param it the iterator to modify
+ *	@return the modified iterator
+ */
+ConcurrentSkipListIterator* concurrent_skiplist_iterator_next(ConcurrentSkipListIterator* it);
+
+/**
+ *	@brief Acces to the value of the iterator.
+ *  @param it the iterator to access
+ *  @return the value designed by the iterator
+ */
+int concurrent_skiplist_iterator_value(ConcurrentSkipListIterator* it);
+
+/** @} */
+
+#endif
@@ -0,0 +1,248 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <pthread.h>
+
+#include "keykernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KEY_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+/* Counts are accumulated on 32 bits lanes : runs are counted by chunks of at most COUNT_CHUNK keys. */
+#define COUNT_CHUNK (1u << 24)
+
+/* Runs shorter than SCAN_KEYS are scanned by keys_lower_bound instead of being halved. */
+#define SCAN_KEYS 64
+
+/*----------------------------------------------------------------------------------------------*/
+/* Scalar kernels, also used for the keys left after the last full vector. */
+
+size_t count_range_scalar(const int* keys, size_t n, int lo, int hi){
+	size_t count = 0;
+	for (size_t i = 0; i < n; i++){
+		count += (keys[i] >= lo) & (keys[i] < hi);
+	}
+	return count;
+}
+
+void aggregate_scalar(const int* keys, size_t n, KeyAggregate* a){
+	for (size_t i = 0; i < n; i++){
+		a->sum += keys[i];
+		a->min = keys[i] < a->min ? keys[i] : a->min;
+		a->max = keys[i] > a->max ? keys[i] : a->max;
+	}
+	a->count += n;
+}
+
+#ifdef KEY_KERNELS_X86
+
+/*----------------------------------------------------------------------------------------------*/
+/* SSE4.1 kernels : 4 keys per vector. */
+
+__attribute__((target("sse4.1")))
+size_t count_range_sse4(const int* keys, size_t n, int lo, int hi){
+	__m128i vlo = _mm_set1_epi32(lo);
+	__m128i vhi = _mm_set1_epi32(hi);
+	__m128i counts = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4){
+		__m128i x = _mm_loadu_si128((const __m128i*)&keys[i]);
+		// lanes in range are -1 : lo <= x and x < hi
+		__m128i in = _mm_andnot_si128(_mm_cmplt_epi32(x, vlo), _mm_cmplt_epi32(x, vhi));
+		counts = _mm_sub_epi32(counts, in);
+	}
+	counts = _mm_add_epi32(counts, _mm_shuffle_epi32(counts, _MM_SHUFFLE(1, 0, 3, 2)));
+	counts = _mm_add_epi32(counts, _mm_shuffle_epi32(counts, _MM_SHUFFLE(2, 3, 0, 1)));
+	return (unsigned int)_mm_cvtsi128_si32(counts) + count_range_scalar(&keys[i], n - i, lo, hi);
+}
+
+__attribute__((target("sse4.1")))
+void aggregate_sse4(const int* keys, size_t n, KeyAggregate* a){
+	__m128i vmin = _mm_set1_epi32(a->min);
+	__m128i vmax = _mm_set1_epi32(a->max);
+	__m128i sums = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4){
+		__m128i x = _mm_loadu_si128((const __m128i*)&keys[i]);
+		vmin = _mm_min_epi32(vmin, x);
+		vmax = _mm_max_epi32(vmax, x);
+		sums = _mm_add_epi64(sums, _mm_cvtepi32_epi64(x));
+		sums = _mm_add_epi64(sums, _mm_cvtepi32_epi64(_mm_srli_si128(x, 8)));
+	}
+	vmin = _mm_min_epi32(vmin, _mm_shuffle_epi32(vmin, _MM_SHUFFLE(1, 0, 3, 2)));
+	vmin = _mm_min_epi32(vmin, _mm_shuffle_epi32(vmin, _MM_SHUFFLE(2, 3, 0, 1)));
+	vmax = _mm_max_epi32(vmax, _mm_shuffle_epi32(vmax, _MM_SHUFFLE(1, 0, 3, 2)));
+	vmax = _mm_max_epi32(vmax, _mm_shuffle_epi32(vmax, _MM_SHUFFLE(2, 3, 0, 1)));
+	long long int lanes[2];
+	_mm_storeu_si128((__m128i*)lanes, sums);
+	a->min = _mm_cvtsi128_si32(vmin);
+	a->max = _mm_cvtsi128_si32(vmax);
+	a->sum += lanes[0] + lanes[1];
+	a->count += i;
+	aggregate_scalar(&keys[i], n - i, a);
+}
+
+/*----------------------------------------------------------------------------------------------*/
+/* AVX2 kernels : 8 keys per vector. */
+
+__attribute__((target("avx2")))
+size_t count_range_avx2(const int* keys, size_t n, int lo, int hi){
+	__m256i vlo = _mm256_set1_epi32(lo);
+	__m256i vhi = _mm256_set1_epi32(hi);
+	__m256i counts = _mm256_setzero_si256();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8){
+		__m256i x = _mm256_loadu_si256((const __m256i*)&keys[i]);
+		// lanes in range are -1 : not (lo > x) and hi > x
+		__m256i in = _mm256_andnot_si256(_mm256_cmpgt_epi32(vlo, x), _mm256_cmpgt_epi32(vhi, x));
+		counts = _mm256_sub_epi32(counts, in);
+	}
+	__m128i half = _mm_add_epi32(_mm256_castsi256_si128(counts), _mm256_extracti128_si256(counts, 1));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+	return (unsigned int)_mm_cvtsi128_si32(half) + count_range_scalar(&keys[i], n - i, lo, hi);
+}
+
+__attribute__((target("avx2")))
+void aggregate_avx2(const int* keys, size_t n, KeyAggregate* a){
+	__m256i vmin = _mm256_set1_epi32(a->min);
+	__m256i vmax = _mm256_set1_epi32(a->max);
+	__m256i sums = _mm256_setzero_si256();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8){
+		__m256i x = _mm256_loadu_si256((const __m256i*)&keys[i]);
+		vmin = _mm256_min_epi32(vmin, x);
+		vmax = _mm256_max_epi32(vmax, x);
+		sums = _mm256_add_epi64(sums, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(x)));
+		sums = _mm256_add_epi64(sums, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(x, 1)));
+	}
+	__m128i min4 = _mm_min_epi32(_mm256_castsi256_si128(vmin), _mm256_extracti128_si256(vmin, 1));
+	__m128i max4 = _mm_max_epi32(_mm256_castsi256_si128(vmax), _mm256_extracti128_si256(vmax, 1));
+	min4 = _mm_min_epi32(min4, _mm_shuffle_epi32(min4, _MM_SHUFFLE(1, 0, 3, 2)));
+	min4 = _mm_min_epi32(min4, _mm_shuffle_epi32(min4, _MM_SHUFFLE(2, 3, 0, 1)));
+	max4 = _mm_max_epi32(max4, _mm_shuffle_epi32(max4, _MM_SHUFFLE(1, 0, 3, 2)));
+	max4 = _mm_max_epi32(max4, _mm_shuffle_epi32(max4, _MM_SHUFFLE(2, 3, 0, 1)));
+	long long int lanes[4];
+	_mm256_storeu_si256((__m256i*)lanes, sums);
+	a->min = _mm_cvtsi128_si32(min4);
+	a->max = _mm_cvtsi128_si32(max4);
+	a->sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	a->count += i;
+	aggregate_scalar(&keys[i], n - i, a);
+}
+
+#endif
+
+/*----------------------------------------------------------------------------------------------*/
+/* Selection of the implementation. */
+
+typedef struct s_Kernels{
+	KeyKernel kernel;
+	size_t (*count_range)(const int*, size_t, int, int);
+	void (*aggregate)(const int*, size_t, KeyAggregate*);
+} Kernels;
+
+static const Kernels scalar_kernels = {KEY_KERNEL_SCALAR, count_range_scalar, aggregate_scalar};
+#ifdef KEY_KERNELS_X86
+static const Kernels sse4_kernels = {KEY_KERNEL_SSE4, count_range_sse4, aggregate_sse4};
+static const Kernels avx2_kernels = {KEY_KERNEL_AVX2, count_range_avx2, aggregate_avx2};
+#endif
+
+/* Kernels in use, selected once by the first call, whatever the number of threads calling at once. */
+static const Kernels* kernels = NULL;
+static pthread_once_t kernels_selected = PTHREAD_ONCE_INIT;
+
+bool kernel_supported(KeyKernel kernel){
+#ifdef KEY_KERNELS_X86
+	__builtin_cpu_init();
+	switch (kernel){
+		case KEY_KERNEL_AVX2 :
+			return __builtin_cpu_supports("avx2");
+		case KEY_KERNEL_SSE4 :
+			return __builtin_cpu_supports("sse4.1");
+		default :
+			return true;
+	}
+#else
+	return kernel == KEY_KERNEL_SCALAR;
+#endif
+}
+
+const Kernels* kernels_of(KeyKernel kernel){
+#ifdef KEY_KERNELS_X86
+	if (kernel == KEY_KERNEL_AVX2){
+		return &avx2_kernels;
+	}
+	if (kernel == KEY_KERNEL_SSE4){
+		return &sse4_kernels;
+	}
+#endif
+	return &scalar_kernels;
+}
+
+static void select_kernels(void){
+	KeyKernel kernel = kernel_supported(KEY_KERNEL_AVX2) ? KEY_KERNEL_AVX2 :
+		kernel_supported(KEY_KERNEL_SSE4) ? KEY_KERNEL_SSE4 : KEY_KERNEL_SCALAR;
+	kernels = kernels_of(kernel);
+}
+
+static const Kernels* current_kernels(void){
+	pthread_once(&kernels_selected, select_kernels);
+	return kernels;
+}
+
+bool keys_set_kernel(KeyKernel kernel){
+	if (!kernel_supported(kernel)){
+		return false;
+	}
+	// the default selection may not come after and override this one
+	pthread_once(&kernels_selected, select_kernels);
+	kernels = kernels_of(kernel);
+	return true;
+}
+
+KeyKernel keys_kernel(void){
+	return current_kernels()->kernel;
+}
+
+const char* keys_kernel_name(KeyKernel kernel){
+	const char* names[] = {"scalar", "sse4", "avx2"};
+	return names[kernel];
+}
+
+/*----------------------------------------------------------------------------------------------*/
+
+size_t keys_count_range(const int* keys, size_t n, int lo, int hi){
+	const Kernels* k = current_kernels();
+	size_t count = 0;
+	for (size_t i = 0; i < n; i += COUNT_CHUNK){
+		count += k->count_range(&keys[i], n - i < COUNT_CHUNK ? n - i : COUNT_CHUNK, lo, hi);
+	}
+	return count;
+}
+
+KeyAggregate keys_aggregate_init(void){
+	KeyAggregate a = {0, 0, INT_MAX, INT_MIN};
+	return a;
+}
+
+void keys_aggregate(const int* keys, size_t n, KeyAggregate* aggregate){
+	current_kernels()->aggregate(keys, n, aggregate);
+}
+
+size_t keys_lower_bound(const int* keys, size_t n, int key){
+	size_t first = 0;
+	while (n > SCAN_KEYS){
+		size_t half = n / 2;
+		if (keys[first + half] < key){
+			first += half + 1;
+			n -= half + 1;
+		}else{
+			n = half + 1;
+		}
+	}
+	// in ascending order, the keys lower than key come first
+	return first + current_kernels()->count_range(&keys[first], n, INT_MIN, key);
+}
@@ -0,0 +1,95 @@
+#ifndef __KEYKERNELS_H__
+#define __KEYKERNELS_H__
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ *	@defgroup KeyKernels Kernels on arrays of keys
+ *  @brief Counting, aggregation and search over contiguous runs of keys
+ *
+ *	Each kernel has a scalar implementation and, on x86 processors, SSE4.1 and AVX2 implementations.
+ *	The widest implementation supported by the processor is selected once, at the first call from any thread,
+ *	unless another one is selected by keys_set_kernel.
+ *  @{
+ */
+
+/**
+ *	@brief Implementations of the kernels.
+ */
+typedef enum e_KeyKernel{KEY_KERNEL_SCALAR, KEY_KERNEL_SSE4, KEY_KERNEL_AVX2} KeyKernel;
+
+/**
+ *	@brief Aggregate of a set of keys.
+ *
+ *	An aggregate is initialized by keys_aggregate_init, then accumulates runs of keys.
+ *	min and max are meaningful when count is not null.
+ */
+typedef struct s_KeyAggregate{
+	size_t count;
+	long long int sum;
+	int min;
+	int max;
+} KeyAggregate;
+
+/**
+ *  @brief Select the implementation of the kernels.
+ *
+ *	@param kernel the implementation to use
+ *  @return false, leaving the implementation unchanged, if the processor does not support it.
+ *	@pre no other thread runs a kernel meanwhile.
+ */
+bool keys_set_kernel(KeyKernel kernel);
+
+/**
+ *  @brief Implementation of the kernels in use.
+ *  @return the implementation selected by keys_set_kernel or, by default, the widest one supported by the processor.
+ */
+KeyKernel keys_kernel(void);
+
+/**
+ *  @brief Name of an implementation of the kernels.
+ *	@param kernel the implementation to name
+ *  @return "scalar", "sse4" or "avx2".
+ */
+const char* keys_kernel_name(KeyKernel kernel);
+
+/**
+ *  @brief Number of keys in [lo, hi).
+ *
+ *	@param keys the keys, in any order
+ *	@param n the number of keys
+ *	@param lo the lowest key to count
+ *	@param hi the strict upper bound of the keys to count
+ *  @return the number of keys k such that lo \f$\le\f$ k \f$<\f$ hi.
+ */
+size_t keys_count_range(const int* keys, size_t n, int lo, int hi);
+
+/**
+ *  @brief Empty aggregate.
+ *  @return an aggregate of no key.
+ */
+KeyAggregate keys_aggregate_init(void);
+
+/**
+ *  @brief Accumulate keys into an aggregate.
+ *
+ *	@param keys the keys, in any order
+ *	@param n the number of keys
+ *	@param aggregate the aggregate to update with the count, sum, min and max of the keys
+ */
+void keys_aggregate(const int* keys, size_t n, KeyAggregate* aggregate);
+
+/**
+ *  @brief Position of the first key greater than or equal to key.
+ *
+ *	@param keys the keys, in ascending order
+ *	@param n the number of keys
+ *	@param key the key to search for
+ *  @return the lowest i such that keys[i] \f$\ge\f$ key, n if there is none.
+ *	@note the run is narrowed by a binary search down to a few cache lines, then scanned by the counting kernel.
+ */
+size_t keys_lower_bound(const int* keys, size_t n, int key);
+
+/** @} */
+
+#endif
@@ -19,21 +19,45 @@ unsigned long int toss(unsigned short *seed) {
 	return (rn >> 17) & MAX_RN;
 }
 
+/* splitmix64 : each step of the sequence gives 64 independent, equiprobable bits. */
+static unsigned long long int splitmix64(unsigned long long int *state) {
+	unsigned long long int z = (*state += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
 RNG rng_initialize(unsigned long long int s, unsigned int max_value){
+	return rng_initialize_generator(s, max_value, RNG_LCG);
+}
+
+RNG rng_initialize_generator(unsigned long long int s, unsigned int max_value, RNGGenerator generator){
 	RNG rng;
 	rng.xsubi[0] = (unsigned short) (s);
 	rng.xsubi[1] = (unsigned short) (s>>16);
 	rng.xsubi[2] = (unsigned short) (s>>32);
+	rng.state = s;
+	rng.generator = generator;
 	rng.max_value = max_value-1;
 	return rng;
 }
 
+void rng_set_upper_bound(RNG *rng, unsigned int max_value) {
+	rng->max_value = max_value-1;
+}
+
 unsigned int rng_upper_bound(const RNG *rng) {
 	return rng->max_value;
 }
 
 unsigned int rng_get_value(RNG *r){
 	unsigned int value;
+	if (r->generator == RNG_CTZ) {
+		// bit i is the i-th toss : the number of trailing zeros follows P(i) = 1/2^(i+1)
+		unsigned long long int bits = splitmix64(&r->state);
+		value = bits ? (unsigned int)__builtin_ctzll(bits) : 64;
+		return value < r->max_value ? value : r->max_value;
+	}
 	for (value = 0; toss(r->xsubi) < MAX_RN/2 && value < r->max_value; ++value);
 	
 	return value;
@@ -10,6 +10,14 @@
  *  @{
  */
 
+/**
+ * @brief Algorithm used to draw the values of a generator.
+ *
+ * RNG_LCG tosses a 48 bits linear congruential generator once per level : the historical sequence, that reference outputs rely on.
+ * RNG_CTZ draws a single 64 bits word from a splitmix64 generator and counts its trailing zero bits, whatever the value.
+ */
+typedef enum s_rng_generator_ {RNG_LCG, RNG_CTZ} RNGGenerator;
+
 /**
  * @brief Random number generator parameters.
  * In order to generate reproducible sequences of random numbers, this structure manages the seed of the sequence that will be updated at each new generated number.
@@ -17,6 +25,10 @@
 typedef struct s_rng_ {
 	/// seed parameters.
 	unsigned short xsubi[3];
+	/// state of the RNG_CTZ generator.
+	unsigned long long int state;
+	/// algorithm drawing the values.
+	RNGGenerator generator;
 	/// generates integer values values in [0 .. max_value]
 	unsigned int max_value;
 } RNG;
@@ -29,6 +41,24 @@ typedef struct s_rng_ {
  */
 RNG rng_initialize(unsigned long long int seed, unsigned int max_value);
 
+/**
+ * @brief Initialize the random sequence of the given generator at the given seed
+ * @param seed is at least a 64 bits unsigned integer
+ * @param max_value : the strict upper bound of the generated values
+ * @param generator : the algorithm drawing the values
+ * @post rng_initialize(s, u) == rng_initialize_generator(s, u, RNG_LCG)
+ * @note a generator holds its whole state : one generator per thread gives re-entrant draws without synchronization.
+ */
+RNG rng_initialize_generator(unsigned long long int seed, unsigned int max_value, RNGGenerator generator);
+
+/**
+ * @brief Change the upper bound of the values generated from now on, keeping the current state of the sequence
+ * @param rng : the sequence generator.
+ * @param max_value : the strict upper bound of the generated values
+ * @post rng_upper_bound(rng) == max_value-1
+ */
+void rng_set_upper_bound(RNG *rng, unsigned int max_value);
+
 /**
  * @brief Returns the upper bound of the generated values
  * @param rng : the sequence generator.
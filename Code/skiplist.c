@@ -1,310 +1,2043 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
 #include <assert.h>
 #include <time.h>
+#include <math.h>
+#include <pthread.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "skiplist.h"
 #include "rng.h"
 typedef struct s_Node Node;
+
+/* One level of a tower : links to the previous and next towers on this level.
+   width is the number of level 0 steps covered by next, the sentinel closing the list standing at position size+1. */
+typedef struct s_Link{
+	Node* next;
+	Node* prev;
+	unsigned int width;
+} Link;
+
+/* A whole tower in a single allocation : the key, its height and one Link per level. */
 struct s_Node{
 	int value;
-	Node** prev;
-	Node** next;
 	int node_level;
+	Link link[];
 };
 
+/* A slab is a block of towers of the same height, chained to the other slabs of the arena. */
+typedef struct s_Slab Slab;
+struct s_Slab{
+	Slab* next;
+};
+
+/* Number of towers in the first slab of a size class, doubled for each new slab up to SLAB_MAX_BYTES. */
+#define SLAB_FIRST_NODES 4
+#define SLAB_MAX_BYTES 16384
+
+/* Towers of one height : recycled towers and the unused part of the current slab. */
+typedef struct s_SizeClass{
+	Node* freelist;
+	char* free_space;
+	unsigned int nb_free_nodes;
+	unsigned int slab_nodes;
+} SizeClass;
+
+/* Per list arena with one size class per tower height. bytes counts the bytes of its slabs. */
+typedef struct s_Arena{
+	Slab* slabs;
+	size_t bytes;
+	SizeClass size_class[];
+} Arena;
+
+#ifdef SKIPLIST_STATS
+/* Counters of the operations on a list, reported by skiplist_stats. */
+typedef struct s_Counters{
+	unsigned long long int nb_inserts;
+	unsigned long long int nb_removes;
+	unsigned long long int nb_duplicates;
+	unsigned long long int nb_searches;
+	unsigned long long int nb_search_operations;
+	unsigned int max_search_operations;
+} Counters;
+#endif
+
+/* Only the levels [0, level) of the sentinel are linked : a level is opened when a tower first reaches it
+   and closed when its last tower is removed. max_level is the capacity of the sentinel. */
 struct s_SkipList{
-	Node** sentinel;
+	Node* sentinel;
 	int max_level;
+	int level;
+	bool adaptive;
 	unsigned int size;
 	RNG rng;
+	Arena* arena;
+	struct s_Versions* versions;
+#ifdef SKIPLIST_STATS
+	Counters counters;
+#endif
 };
+
+/* A live snapshot of a list keeps the values inserted in and removed from the list since it was taken : the values
+   of the snapshot are those of the list, but for the added ones, and the removed ones. */
+typedef struct s_Version{
+	unsigned long long int id;
+	SkipList* added;
+	SkipList* removed;
+	struct s_Version* next;
+} Version;
+
+/* Snapshots of a list, allocated with its first snapshot and kept until the list is deleted.
+   The writer of the list holds lock for writing while it modifies the list, the snapshot readers hold it for reading
+   while they read the list. The towers removed while snapshots are live are retired, chained by their link to their
+   predecessor, and freed with the last live snapshot. A list deleted while snapshots are live is freed with the last
+   one. */
+typedef struct s_Versions{
+	pthread_rwlock_t lock;
+	Version* live;
+	Node* retired;
+	unsigned long long int last_id;
+	bool deleted;
+} Versions;
+
+/* Update of the counters, compiled out without SKIPLIST_STATS. Searches take a const list : as every SkipList
+   is allocated by skiplist_create, its counters may be modified through a cast. */
+#ifdef SKIPLIST_STATS
+#define COUNT(d, counter, n) (((SkipList*)(d))->counters.counter += (n))
+#define COUNT_SEARCH(d, operations) do { \
+		Counters* counters = &((SkipList*)(d))->counters; \
+		counters->nb_searches += 1; \
+		counters->nb_search_operations += (operations); \
+		if ((operations) > counters->max_search_operations){ \
+			counters->max_search_operations = (operations); \
+		} \
+	} while (0)
+#else
+#define COUNT(d, counter, n) ((void)0)
+#define COUNT_SEARCH(d, operations) ((void)0)
+#endif
+
+static size_t node_size(int level){
+	return sizeof(Node) + (size_t)level*sizeof(Link);
+}
+
+Arena* arena_create(int nblevels){
+	Arena* a = calloc(1, sizeof(Arena) + (size_t)nblevels*sizeof(SizeClass));
+	if (!a){
+		fprintf(stderr, "Memory allocation failed for the SkipList arena\n");
+		exit(1);
+	}
+	for (int i = 0; i < nblevels; i++){
+		a->size_class[i].slab_nodes = SLAB_FIRST_NODES;
+	}
+	return a;
+}
+
+void arena_delete(Arena** a){
+	Slab* slab = (*a)->slabs;
+	while (slab){
+		Slab* next_slab = slab->next;
+		free(slab);
+		slab = next_slab;
+	}
+	free(*a);
+	*a = NULL;
+}
+
+Node* arena_alloc(Arena* a, int level){
+	SizeClass* c = &a->size_class[level-1];
+	Node* node = c->freelist;
+	if (node){
+		c->freelist = node->link[0].next;
+		return node;
+	}
+	if (c->nb_free_nodes == 0){
+		Slab* slab = malloc(sizeof(Slab) + c->slab_nodes*node_size(level));
+		if (!slab){
+			fprintf(stderr, "Failed to allocated memory for a new slab\n");
+			exit(1);
+		}
+		slab->next = a->slabs;
+		a->slabs = slab;
+		a->bytes += sizeof(Slab) + c->slab_nodes*node_size(level);
+		c->free_space = (char*)(slab+1);
+		c->nb_free_nodes = c->slab_nodes;
+		if (2*c->slab_nodes*node_size(level) <= SLAB_MAX_BYTES){
+			c->slab_nodes *= 2;
+		}
+	}
+	node = (Node*)c->free_space;
+	c->free_space += node_size(level);
+	c->nb_free_nodes -= 1;
+	return node;
+}
+
+void arena_free(Arena* a, Node* node){
+	SizeClass* c = &a->size_class[node->node_level-1];
+	node->link[0].next = c->freelist;
+	c->freelist = node;
+}
  
 SkipList* skiplist_create(int nblevels) {
+	return skiplist_create_with_allocator(nblevels, MALLOC_ALLOCATOR);
+}
+
+/* Number of levels drawn for an adaptive list of the given size : 1 + floor(log2(size+1)). */
+static int adaptive_levels(unsigned int size){
+	int levels = 32 - __builtin_clz(size + 1);
+	return levels < SKIPLIST_MAX_LEVEL ? levels : SKIPLIST_MAX_LEVEL;
+}
+
+SkipList* skiplist_create_with_allocator(int nblevels, SkipListAllocator allocator) {
 	//nblevels = rng_initialize(0, nblevels);
+	bool adaptive = nblevels == 0;
+	// the stack iterators and the linking passes hold one entry per level
+	if (adaptive || nblevels > SKIPLIST_MAX_LEVEL){
+		nblevels = SKIPLIST_MAX_LEVEL;
+	}
 	SkipList* l;
-	l = malloc(sizeof(SkipList)+nblevels*sizeof(Node*)); 
+	l = malloc(sizeof(SkipList)+node_size(nblevels)); 
 	if (!l)
 	{
 		fprintf(stderr, "Memory allocation failed for Skiplist,\n");
 		exit(1);
 	}
-	l->max_level = nblevels;
-	l->sentinel = (Node**)(l+1);
-	l->size = 0;
-	for (int i = 0; i < nblevels; i++){
-		(l->sentinel)[i] = malloc(sizeof(Node));
+	l->max_level = nblevels;
+	l->level = 1;
+	l->adaptive = adaptive;
+	l->sentinel = (Node*)(l+1);
+	l->size = 0;
+	// the sentinel holds no value : the end of a level is detected by pointer identity with it
+	l->sentinel->node_level = nblevels;
+	l->sentinel->link[0].next = l->sentinel;
+	l->sentinel->link[0].prev = l->sentinel;
+	l->sentinel->link[0].width = 1;
+	l->rng = rng_initialize(0x7FFFFFFF, adaptive ? adaptive_levels(0) : nblevels);
+	l->arena = (allocator == ARENA_ALLOCATOR) ? arena_create(nblevels) : NULL;
+	l->versions = NULL;
+#ifdef SKIPLIST_STATS
+	l->counters = (Counters){0, 0, 0, 0, 0, 0};
+#endif
+
+	return l;
+}
+
+SkipList* skiplist_set_generator(SkipList* d, RNGGenerator generator) {
+	d->rng = rng_initialize_generator(0x7FFFFFFF, rng_upper_bound(&d->rng) + 1, generator);
+	return d;
+}
+
+Node* node_create_with_level(SkipList* d, int value, int level){
+	Node* node = d->arena ? arena_alloc(d->arena, level) : malloc(node_size(level));
+	if (!node){
+		fprintf(stderr, "Failed to allocated memory for a new node\n");
+		exit(1);
+	}
+	node->value = value;
+	node->node_level = level;
+	return node;
+}
+
+Node* node_create(SkipList* d, int value){
+	return node_create_with_level(d, value, rng_get_value(&d->rng) + 1);
+}
+
+/* Follow the size of an adaptive list with the bound of its random generator. */
+void update_height_bound(SkipList* d){
+	if (d->adaptive){
+		rng_set_upper_bound(&d->rng, (unsigned int)adaptive_levels(d->size));
+	}
+}
+
+/* Open the levels [d->level, level) of the sentinel, empty so far, before binding a tower of the given level.
+   The sentinel becomes the predecessor, at position 0, of the tower on these levels. */
+void raise_level(SkipList* d, int level, Node** update, unsigned int* rank){
+	Node* sentinel = d->sentinel;
+	for (int i = d->level; i < level; i++){
+		sentinel->link[i].next = sentinel;
+		sentinel->link[i].prev = sentinel;
+		sentinel->link[i].width = d->size + 1;
+		update[i] = sentinel;
+		rank[i] = 0;
+	}
+	if (level > d->level){
+		d->level = level;
+	}
+}
+
+/* Close the top levels left empty by a removal. */
+void lower_level(SkipList* d){
+	while (d->level > 1 && d->sentinel->link[d->level-1].next == d->sentinel){
+		d->level -= 1;
+	}
+}
+
+/* Unbind a tower whose predecessors on each level of the list are stored in update. */
+void unlink_node(Node** update, Node* to_delete, int max_level){
+	int i;
+	for (i = 0; i < to_delete->node_level; i++){
+		Node* prev_node = to_delete->link[i].prev;
+		Node* next_node = to_delete->link[i].next;
+		prev_node->link[i].next = next_node;
+		prev_node->link[i].width += to_delete->link[i].width - 1;
+		next_node->link[i].prev = prev_node;
+	}
+	for (; i < max_level; i++){
+		update[i]->link[i].width -= 1;
+	}
+}
+
+void node_free(SkipList* d, Node* node){
+	if (d->arena){
+		arena_free(d->arena, node);
+	}else{
+		free(node);
+	}
+}
+
+/* Whether snapshots of d are live. Only the writer of d takes snapshots : a list without live snapshot stays so until
+   its writer takes one, and a list whose last snapshot was released never had its lock again. */
+bool has_live_snapshots(const SkipList* d){
+	return d->versions && __atomic_load_n(&d->versions->live, __ATOMIC_ACQUIRE);
+}
+
+/* Exclusive access of the writer of d to the list, against the readers of its live snapshots.
+   Returns whether the lock was taken, to give to end_write. */
+bool begin_write(SkipList* d){
+	if (!has_live_snapshots(d)){
+		return false;
+	}
+	pthread_rwlock_wrlock(&d->versions->lock);
+	return true;
+}
+
+void end_write(SkipList* d, bool locked){
+	if (locked){
+		pthread_rwlock_unlock(&d->versions->lock);
+	}
+}
+
+/* Record in each live snapshot of d the insert of a value : a value removed since the snapshot is back in the list as
+   in the snapshot, otherwise it is added. */
+void record_insert(SkipList* d, int value){
+	for (Version* s = d->versions ? d->versions->live : NULL; s; s = s->next){
+		unsigned int removed = s->removed->size;
+		skiplist_remove(s->removed, value);
+		if (s->removed->size == removed){
+			skiplist_insert(s->added, value);
+		}
+	}
+}
+
+/* Record in each live snapshot of d the remove of a value, added to the list since the snapshot or removed from it. */
+void record_remove(SkipList* d, int value){
+	for (Version* s = d->versions ? d->versions->live : NULL; s; s = s->next){
+		unsigned int added = s->added->size;
+		skiplist_remove(s->added, value);
+		if (s->added->size == added){
+			skiplist_insert(s->removed, value);
+		}
+	}
+}
+
+/* Free a tower unbound from d, or retire it while snapshots of d are live : their iterators may stand on it.
+   A retired tower keeps its link to its successor at the time of its removal, and a null width marks it.
+   Called by the writer holding the lock of the snapshots. */
+void release_node(SkipList* d, Node* node){
+	if (!has_live_snapshots(d)){
+		node_free(d, node);
+		return;
+	}
+	record_remove(d, node->value);
+	node->link[0].width = 0;
+	node->link[0].prev = d->versions->retired;
+	d->versions->retired = node;
+}
+
+void delete_node(Node** ptrToNode, Node** update, SkipList* l){
+	bool locked = begin_write(l);
+	unlink_node(update, *ptrToNode, l->level);
+	release_node(l, *ptrToNode);
+	*ptrToNode = NULL;
+	l->size -=1;
+	COUNT(l, nb_removes, 1);
+	lower_level(l);
+	update_height_bound(l);
+	end_write(l, locked);
+}
+
+void skiplist_delete(SkipList** d) {
+	SkipList* l = *d;
+	*d = NULL;
+	if (l->versions){
+		Versions* versions = l->versions;
+		pthread_rwlock_wrlock(&versions->lock);
+		bool live = versions->live != NULL;
+		// the readers of the live snapshots keep the list until the last one is released
+		versions->deleted = live;
+		pthread_rwlock_unlock(&versions->lock);
+		if (live){
+			return;
+		}
+		pthread_rwlock_destroy(&versions->lock);
+		free(versions);
+	}
+	if (l->arena){
+		// every tower lives in a slab of the arena
+		arena_delete(&l->arena);
+		free(l);
+		return;
+	}
+	Node* to_delete = l->sentinel->link[0].next;
+	while (to_delete != l->sentinel){
+		Node* next_node = to_delete->link[0].next;
+		free(to_delete);
+		to_delete = next_node;
+	}
+	free(l);
+
+}
+
+int compare_int(const void* a, const void* b){
+	int x = *(const int*)a;
+	int y = *(const int*)b;
+	return (x > y) - (x < y);
+}
+
+/* Sorted and deduplicated copy of values, sorting only when the input is not already strictly increasing. */
+int* sorted_unique_values(const int* values, size_t n, size_t* nb_unique){
+	int* sorted = malloc((n ? n : 1)*sizeof(int));
+	if (!sorted){
+		fprintf(stderr, "Failed to allocated memory for sorting the values\n");
+		exit(1);
+	}
+	bool is_sorted = true;
+	for (size_t i = 0; i < n; i++){
+		sorted[i] = values[i];
+		is_sorted = is_sorted && (i == 0 || values[i-1] < values[i]);
+	}
+	if (!is_sorted){
+		qsort(sorted, n, sizeof(int), compare_int);
+	}
+	size_t m = 0;
+	for (size_t i = 0; i < n; i++){
+		if (m == 0 || sorted[m-1] != sorted[i]){
+			sorted[m++] = sorted[i];
+		}
+	}
+	*nb_unique = m;
+	return sorted;
+}
+
+/* Left to right linking of the towers of a list, keeping the last tower of each level and its position.
+   A list has at most SKIPLIST_MAX_LEVEL levels, bounded by skiplist_create_with_allocator. */
+typedef struct s_TailLinks{
+	Node* tail[SKIPLIST_MAX_LEVEL];
+	unsigned int tail_pos[SKIPLIST_MAX_LEVEL];
+	unsigned int size;
+	int levels;
+} TailLinks;
+
+/* Start linking the towers of d, none higher than levels, after its sentinel. */
+void tail_links_start(SkipList* d, TailLinks* t, int levels){
+	assert(levels <= SKIPLIST_MAX_LEVEL);
+	for (int i = 0; i < levels; i++){
+		t->tail[i] = d->sentinel;
+		t->tail_pos[i] = 0;
+	}
+	t->size = 0;
+	t->levels = levels;
+}
+
+/* Link node after the towers linked so far. */
+void tail_links_append(TailLinks* t, Node* node){
+	unsigned int pos = ++t->size;
+	for (int i = 0; i < node->node_level; i++){
+		t->tail[i]->link[i].next = node;
+		t->tail[i]->link[i].width = pos - t->tail_pos[i];
+		node->link[i].prev = t->tail[i];
+		t->tail[i] = node;
+		t->tail_pos[i] = pos;
+	}
+}
+
+/* Close each level on the sentinel : d holds the towers linked. */
+void tail_links_close(SkipList* d, TailLinks* t){
+	Node* sentinel = d->sentinel;
+	for (int i = 0; i < t->levels; i++){
+		t->tail[i]->link[i].next = sentinel;
+		t->tail[i]->link[i].width = t->size + 1 - t->tail_pos[i];
+		sentinel->link[i].prev = t->tail[i];
+	}
+	d->level = t->levels;
+	d->size = t->size;
+	lower_level(d);
+}
+
+/* Link the towers of sorted values in one left to right pass.
+   The tower at position p is heights[p-1] high when heights is given. Otherwise, with balanced set, it is
+   1 + (number of trailing zeros of p) high, as in a perfect skip list, and it is drawn at random when not.
+   No tower may be higher than levels. */
+void link_sorted_values(SkipList* d, const int* sorted, size_t m, int levels, bool balanced, const unsigned char* heights){
+	TailLinks t;
+	tail_links_start(d, &t, levels);
+	for (size_t k = 0; k < m; k++){
+		unsigned int pos = (unsigned int)k + 1;
+		Node* node;
+		if (heights){
+			node = node_create_with_level(d, sorted[k], heights[k]);
+		}else if (balanced){
+			int level = 1;
+			for (unsigned int p = pos; (p & 1) == 0 && level < levels; p >>= 1){
+				++level;
+			}
+			node = node_create_with_level(d, sorted[k], level);
+		}else{
+			node = node_create(d, sorted[k]);
+		}
+		tail_links_append(&t, node);
+	}
+	tail_links_close(d, &t);
+}
+
+SkipList* build_from_array(const int* values, size_t n, int nblevels, bool balanced){
+	size_t m;
+	int* sorted = sorted_unique_values(values, n, &m);
+	SkipList* d = skiplist_create(nblevels);
+	int levels = d->adaptive ? adaptive_levels((unsigned int)m) : d->max_level;
+	rng_set_upper_bound(&d->rng, (unsigned int)levels);
+	link_sorted_values(d, sorted, m, levels, balanced, NULL);
+	COUNT(d, nb_inserts, m);
+	COUNT(d, nb_duplicates, n - m);
+	free(sorted);
+	return d;
+}
+
+SkipList* skiplist_build_from_array(const int* values, size_t n, int nblevels){
+	return build_from_array(values, n, nblevels, false);
+}
+
+SkipList* skiplist_build_balanced_from_array(const int* values, size_t n, int nblevels){
+	return build_from_array(values, n, nblevels, true);
+}
+
+unsigned int skiplist_size(const SkipList *d){
+	return d->size;
+}
+
+int skiplist_at(const SkipList *d, unsigned int i){
+	Node* sentinel = d->sentinel;
+	Node* current_node = sentinel;
+	unsigned int pos = 0;
+	// the ith element stands at position i+1, the sentinel being at position 0
+	for (int level = d->level-1; level >= 0; --level){
+		while (current_node->link[level].next != sentinel && pos + current_node->link[level].width <= i+1){
+			pos += current_node->link[level].width;
+			current_node = current_node->link[level].next;
+		}
+	}
+	return current_node->value;
+}
+
+
+void skiplist_map(const SkipList* d, ScanOperator f, void *user_data){
+	Node* sentinel = d->sentinel;
+	for(Node* element = sentinel->link[0].next; element != sentinel; element = element->link[0].next){
+		f(element->value, user_data);
+	}
+}
+
+/* Iterative top-down descent.
+   Returns the last tower whose value is lower than value and, when update is not NULL, stores in update[i]
+   the last such tower on level i, i.e. the predecessors to bind or unbind on insert and remove, and
+   in rank[i] its position in the list (the sentinel being at position 0).
+   Each successor compared to value, except the sentinel, counts as one operation. */
+Node* find_predecessors(const SkipList* d, int value, Node** update, unsigned int* rank, unsigned int *nb_operations){
+	Node* sentinel = d->sentinel;
+	Node* node = sentinel;
+	unsigned int pos = 0;
+	unsigned int operations = 0;
+	for (int level = d->level-1; level >= 0; --level){
+		Node* next = node->link[level].next;
+		while (next != sentinel){
+			++operations;
+			if (next->value >= value){
+				break;
+			}
+			pos += node->link[level].width;
+			node = next;
+			next = node->link[level].next;
+		}
+		if (update){
+			update[level] = node;
+			rank[level] = pos;
+		}
+	}
+	*nb_operations += operations;
+	return node;
+}
+
+void bind_nodes(Node* prev_node, Node* node_to_insert, Node* next_node, int insert_level){
+	//bind to the prev node
+	prev_node->link[insert_level].next = node_to_insert;
+	node_to_insert->link[insert_level].prev = prev_node;
+	//bind to next node
+	node_to_insert->link[insert_level].next = next_node;
+	next_node->link[insert_level].prev = node_to_insert;
+}
+
+/* Bind a tower at position rank[0]+1, after the predecessors stored in update, and adjust the widths of all levels. */
+void bind_towers(Node** update, unsigned int* rank, Node* node_to_insert, int max_level){
+	unsigned int pos = rank[0] + 1;
+	int i;
+	for (i = 0; i < node_to_insert->node_level; i++){
+		Link* prev_link = &update[i]->link[i];
+		node_to_insert->link[i].width = prev_link->width - (pos - rank[i]) + 1;
+		prev_link->width = pos - rank[i];
+		bind_nodes(update[i], node_to_insert, prev_link->next, i);
+	}
+	for (; i < max_level; i++){
+		update[i]->link[i].width += 1;
+	}
+}
+
+SkipList* skiplist_insert(SkipList* d, int value) {
+	return skiplist_insert_ex(d, value, NULL);
+}
+
+/* Predecessors of a value greater than all the values of the list : the last tower of each level, i.e. the
+   predecessor of the sentinel, whose position follows from the width of its link to the sentinel, at position size+1.
+   The sentinel keeps them up to date on every insert and remove : appends need no search. */
+void tail_predecessors(const SkipList* d, Node** update, unsigned int* rank){
+	Node* sentinel = d->sentinel;
+	for (int i = 0; i < d->level; i++){
+		update[i] = sentinel->link[i].prev;
+		rank[i] = d->size + 1 - update[i]->link[i].width;
+	}
+}
+
+/* True when value goes after the last tower of the list. */
+static bool is_append(const SkipList* d, int value){
+	Node* last = d->sentinel->link[0].prev;
+	return last == d->sentinel || last->value < value;
+}
+
+/* Positions of the predecessors stored in update on the levels [0, levels), measured back from update[0] along the
+   links of each level. Only their differences matter to bind_towers : they are absolute, the sentinel at 0, when
+   the new tower raises the level of the list, relative to d->size otherwise. */
+void predecessors_positions(const SkipList* d, Node** update, unsigned int* rank, int levels){
+	bool absolute = levels > d->level;
+	if (absolute){
+		levels = d->level;
+	}
+	rank[0] = d->size;
+	for (int i = 1; i < levels; i++){
+		rank[i] = rank[i-1];
+		for (Node* node = update[i-1]; node != update[i]; ){
+			node = node->link[i-1].prev;
+			rank[i] -= node->link[i-1].width;
+		}
+	}
+	if (absolute){
+		int top = levels-1;
+		unsigned int pos = 0;
+		for (Node* node = update[top]; node != d->sentinel; ){
+			node = node->link[top].prev;
+			pos += node->link[top].width;
+		}
+		unsigned int offset = rank[top] - pos;
+		for (int i = 0; i < levels; i++){
+			rank[i] -= offset;
+		}
+	}
+}
+
+/* Insert value after the predecessors stored in update, at the positions stored in rank, unless the successor
+   of update[0] already holds it. Returns the tower holding value.
+   When rank is NULL, the positions are measured by predecessors_positions up to the height of the new tower. */
+Node* insert_at(SkipList* d, int value, Node** update, unsigned int* rank, bool* inserted){
+	Node* next_node = update[0]->link[0].next;
+	bool is_new = next_node == d->sentinel || next_node->value != value;
+	if (inserted){
+		*inserted = is_new;
+	}
+	// Case duplication : the tower in place already holds the value
+	if (!is_new){
+		COUNT(d, nb_duplicates, 1);
+		return next_node;
+	}
+	bool locked = begin_write(d);
+	Node* new_node = node_create(d, value);
+	unsigned int positions[d->max_level];
+	if (!rank){
+		rank = positions;
+		predecessors_positions(d, update, rank, new_node->node_level);
+	}
+	raise_level(d, new_node->node_level, update, rank);
+	bind_towers(update, rank, new_node, d->level);
+	d->size +=1;
+	COUNT(d, nb_inserts, 1);
+	update_height_bound(d);
+	record_insert(d, value);
+	end_write(d, locked);
+	return new_node;
+}
+
+SkipList* skiplist_insert_ex(SkipList* d, int value, bool* inserted) {
+	Node* update[d->max_level];
+	unsigned int rank[d->max_level];
+	unsigned int nb_operations = 0;
+	if (is_append(d, value)){
+		tail_predecessors(d, update, rank);
+	}else{
+		find_predecessors(d, value, update, rank, &nb_operations);
+	}
+	insert_at(d, value, update, rank, inserted);
+	return d;
+}
+
+
+bool skiplist_search(const SkipList* d, int value, unsigned int *nb_operations){
+	unsigned int operations = 0;
+	Node* next_node = find_predecessors(d, value, NULL, NULL, &operations)->link[0].next;
+	*nb_operations += operations;
+	COUNT_SEARCH(d, operations);
+	return next_node != d->sentinel && next_node->value == value;
+}
+
+/* Finger search : update holds the predecessors of a value lower than or equal to value.
+   Climb while the successor of the predecessor is still lower than value, then descend from there,
+   restarting each lower level from the furthest of the current tower and the previous predecessor. */
+Node* find_predecessors_from(const SkipList* d, int value, Node** update, unsigned int *nb_operations){
+	Node* sentinel = d->sentinel;
+	unsigned int operations = 0;
+	int top = -1;
+	while (top+1 < d->level){
+		Node* next = update[top+1]->link[top+1].next;
+		if (next == sentinel){
+			break;
+		}
+		++operations;
+		if (next->value >= value){
+			break;
+		}
+		++top;
+	}
+	Node* node = top >= 0 ? update[top] : update[0];
+	for (int level = top; level >= 0; --level){
+		if (node == sentinel || (update[level] != sentinel && update[level]->value > node->value)){
+			node = update[level];
+		}
+		Node* next = node->link[level].next;
+		while (next != sentinel){
+			++operations;
+			if (next->value >= value){
+				break;
+			}
+			node = next;
+			next = node->link[level].next;
+		}
+		update[level] = node;
+	}
+	*nb_operations += operations;
+	return update[0];
+}
+
+/* Predecessors of a tower on the levels above its top level : walking back from its predecessor on its top level,
+   the predecessor on level i is the first tower higher than i. The sentinel is higher than any level. */
+static void upper_predecessors(const SkipList* d, Node* node, Node** update){
+	Node* prev_node = node->link[node->node_level-1].prev;
+	for (int i = node->node_level; i < d->level; i++){
+		while (prev_node->node_level <= i){
+			prev_node = prev_node->link[i-1].prev;
+		}
+		update[i] = prev_node;
+	}
+}
+
+SkipList* skiplist_insert_hint(SkipList* d, SkipListIterator* hint, int value){
+	assert(hint->collection == d);
+	Node* update[d->max_level];
+	unsigned int rank[d->max_level];
+	unsigned int nb_operations = 0;
+	Node* sentinel = d->sentinel;
+	Node* node = hint->current;
+	unsigned int* positions = rank;
+	if (is_append(d, value)){
+		tail_predecessors(d, update, rank);
+	}else if (hint->direction == FORWARD_ITERATOR && (hint->predecessors[0] == sentinel || hint->predecessors[0]->value < value)){
+		// the predecessors of the iterator are those of a value lower than value
+		for (int i = 0; i < d->level; i++){
+			update[i] = hint->predecessors[i];
+		}
+		find_predecessors_from(d, value, update, &nb_operations);
+		positions = NULL;
+	}else if (hint->direction == BACKWARD_ITERATOR && node != sentinel && node->value < value){
+		// the tower of the iterator is the predecessor of value on its levels
+		for (int i = 0; i < node->node_level; i++){
+			update[i] = node;
+		}
+		upper_predecessors(d, node, update);
+		find_predecessors_from(d, value, update, &nb_operations);
+		positions = NULL;
+	}else{
+		// value is before the iterator : search from the top
+		find_predecessors(d, value, update, rank, &nb_operations);
+	}
+	hint->current = insert_at(d, value, update, positions, NULL);
+	if (hint->direction == FORWARD_ITERATOR){
+		for (int i = 0; i < d->level; i++){
+			hint->predecessors[i] = update[i];
+		}
+	}
+	return d;
+}
+
+typedef struct s_KeyIndex{
+	int key;
+	size_t index;
+} KeyIndex;
+
+int compare_key_index(const void* a, const void* b){
+	const KeyIndex* x = a;
+	const KeyIndex* y = b;
+	return (x->key > y->key) - (x->key < y->key);
+}
+
+void skiplist_search_batch(const SkipList* d, const int* keys, size_t n, bool* found, unsigned int* ops){
+	if (n == 0){
+		return;
+	}
+	KeyIndex* order = malloc(n*sizeof(KeyIndex));
+	if (!order){
+		fprintf(stderr, "Failed to allocated memory for sorting the keys\n");
+		exit(1);
+	}
+	bool is_sorted = true;
+	for (size_t i = 0; i < n; i++){
+		order[i].key = keys[i];
+		order[i].index = i;
+		is_sorted = is_sorted && (i == 0 || keys[i-1] <= keys[i]);
+	}
+	if (!is_sorted){
+		qsort(order, n, sizeof(KeyIndex), compare_key_index);
+	}
+	Node* update[d->max_level];
+	unsigned int rank[d->max_level];
+	for (size_t i = 0; i < n; i++){
+		unsigned int nb_operations = 0;
+		Node* prev_node;
+		if (i == 0){
+			prev_node = find_predecessors(d, order[i].key, update, rank, &nb_operations);
+		}else{
+			prev_node = find_predecessors_from(d, order[i].key, update, &nb_operations);
+		}
+		Node* next_node = prev_node->link[0].next;
+		found[order[i].index] = next_node != d->sentinel && next_node->value == order[i].key;
+		COUNT_SEARCH(d, nb_operations);
+		if (ops){
+			ops[order[i].index] = nb_operations;
+		}
+	}
+	free(order);
+}
+
+/* Prefetch of a tower, ignored by the compilers without __builtin_prefetch. */
+#ifdef __GNUC__
+#define PREFETCH(address) __builtin_prefetch(address)
+#else
+#define PREFETCH(address) ((void)(address))
+#endif
+
+bool skiplist_search_prefetch(const SkipList* d, int value, unsigned int *nb_operations){
+	Node* sentinel = d->sentinel;
+	Node* node = sentinel;
+	unsigned int operations = 0;
+	Node* next = sentinel;
+	for (int level = d->level-1; level >= 0; --level){
+		next = node->link[level].next;
+		while (next != sentinel){
+			// next is lower than value : its successor is compared next, otherwise the successor of node below
+			Node* after = next->link[level].next;
+			PREFETCH(after);
+			if (level > 0){
+				PREFETCH(node->link[level-1].next);
+			}
+			++operations;
+			if (next->value >= value){
+				break;
+			}
+			node = next;
+			next = after;
+		}
+	}
+	*nb_operations += operations;
+	COUNT_SEARCH(d, operations);
+	return next != sentinel && next->value == value;
+}
+
+/* One search of an interleaved batch : the descent stands on node at level, and next is the prefetched tower
+   to compare to the key at the next turn. */
+typedef struct s_SearchState{
+	Node* node;
+	Node* next;
+	int level;
+	unsigned int operations;
+	size_t index;
+} SearchState;
+
+static void search_start(const SkipList* d, SearchState* s, size_t index){
+	s->node = d->sentinel;
+	s->level = d->level-1;
+	s->next = s->node->link[s->level].next;
+	PREFETCH(s->next);
+	s->operations = 0;
+	s->index = index;
+}
+
+/* Compare next to value, then move to the next tower to compare and prefetch it, descending without comparison
+   through the levels ending on the sentinel. Returns true when the search is over, next being then the first
+   tower not lower than value. */
+static bool search_step(const SkipList* d, SearchState* s, int value){
+	Node* sentinel = d->sentinel;
+	if (s->next != sentinel){
+		++s->operations;
+		if (s->next->value < value){
+			s->node = s->next;
+			s->next = s->node->link[s->level].next;
+			PREFETCH(s->next);
+			return false;
+		}
+	}
+	while (s->level > 0){
+		--s->level;
+		s->next = s->node->link[s->level].next;
+		if (s->next != sentinel){
+			PREFETCH(s->next);
+			return false;
+		}
+	}
+	return true;
+}
+
+void skiplist_search_interleaved(const SkipList* d, const int* keys, size_t n, bool* found, unsigned int* ops){
+	Node* sentinel = d->sentinel;
+	SearchState state[SKIPLIST_SEARCH_GROUP];
+	size_t started = 0;
+	int active = 0;
+	for (; active < SKIPLIST_SEARCH_GROUP && started < n; active++){
+		search_start(d, &state[active], started++);
+	}
+	while (active > 0){
+		for (int i = 0; i < active; ){
+			SearchState* s = &state[i];
+			int value = keys[s->index];
+			if (!search_step(d, s, value)){
+				++i;
+				continue;
+			}
+			found[s->index] = s->next != sentinel && s->next->value == value;
+			if (ops){
+				ops[s->index] = s->operations;
+			}
+			COUNT_SEARCH(d, s->operations);
+			// the slot takes the next key, or the last running search when all keys are started
+			if (started < n){
+				search_start(d, s, started++);
+				++i;
+			}else{
+				*s = state[--active];
+			}
+		}
+	}
+}
+
+int skiplist_rank(const SkipList* d, int value){
+	Node* update[d->max_level];
+	unsigned int rank[d->max_level];
+	unsigned int nb_operations = 0;
+	Node* next_node = find_predecessors(d, value, update, rank, &nb_operations)->link[0].next;
+	if (next_node != d->sentinel && next_node->value == value){
+		return (int)rank[0];
+	}
+	return -1;
+}
+
+SkipList* skiplist_remove(SkipList* d, int value){
+	Node* update[d->max_level];
+	unsigned int rank[d->max_level];
+	unsigned int nb_operations = 0;
+	Node* to_remove = find_predecessors(d, value, update, rank, &nb_operations)->link[0].next;
+	// If found the node
+	if (to_remove != d->sentinel && to_remove->value == value){
+		delete_node(&to_remove, update, d);
+	}
+	return d;
+}
+
+SkipList* skiplist_remove_range(SkipList* d, int lo, int hi){
+	if (lo >= hi){
+		return d;
+	}
+	Node* update[d->max_level];
+	unsigned int rank[d->max_level];
+	Node* last[d->max_level];
+	unsigned int last_rank[d->max_level];
+	unsigned int nb_operations = 0;
+	Node* first = find_predecessors(d, lo, update, rank, &nb_operations)->link[0].next;
+	Node* after_last = find_predecessors(d, hi, last, last_rank, &nb_operations)->link[0].next;
+	unsigned int nb_removed = 0;
+	for (Node* node = first; node != after_last; node = node->link[0].next){
+		++nb_removed;
+	}
+	if (nb_removed == 0){
+		return d;
+	}
+	bool locked = begin_write(d);
+	// on each level, the run (update[i], last[i]] is cut out at once
+	for (int i = 0; i < d->level; i++){
+		Node* next_node = last[i]->link[i].next;
+		update[i]->link[i].width = last_rank[i] + last[i]->link[i].width - rank[i] - nb_removed;
+		update[i]->link[i].next = next_node;
+		next_node->link[i].prev = update[i];
+	}
+	for (unsigned int k = 0; k < nb_removed; k++){
+		Node* next_node = first->link[0].next;
+		release_node(d, first);
+		first = next_node;
+	}
+	d->size -= nb_removed;
+	COUNT(d, nb_removes, nb_removed);
+	lower_level(d);
+	update_height_bound(d);
+	end_write(d, locked);
+	return d;
+}
+
+void skiplist_range_map(const SkipList* d, int lo, int hi, ScanOperator f, void *user_data){
+	Node* sentinel = d->sentinel;
+	unsigned int nb_operations = 0;
+	Node* element = find_predecessors(d, lo, NULL, NULL, &nb_operations)->link[0].next;
+	for(; element != sentinel && element->value < hi; element = element->link[0].next){
+		f(element->value, user_data);
+	}
+}
+
+void skiplist_map_batch(const SkipList* d, BatchOperator f, void *user_data){
+	Node* sentinel = d->sentinel;
+	int batch[SKIPLIST_BATCH_KEYS];
+	size_t n = 0;
+	for(Node* element = sentinel->link[0].next; element != sentinel; element = element->link[0].next){
+		batch[n++] = element->value;
+		if (n == SKIPLIST_BATCH_KEYS){
+			f(batch, n, user_data);
+			n = 0;
+		}
+	}
+	if (n > 0){
+		f(batch, n, user_data);
 	}
-	for (int i = 0; i < nblevels; i++)
-	{
-		(l->sentinel)[i]->next = l->sentinel;
-		l->sentinel[i]->prev = l->sentinel;
-		l->sentinel[i]->value = -1;      
-        l->sentinel[i]->node_level = nblevels; 
+}
+
+void skiplist_aggregate_range(const SkipList* d, int lo, int hi, KeyAggregate* aggregate){
+	Node* sentinel = d->sentinel;
+	unsigned int nb_operations = 0;
+	int batch[SKIPLIST_BATCH_KEYS];
+	size_t n = 0;
+	Node* element = find_predecessors(d, lo, NULL, NULL, &nb_operations)->link[0].next;
+	for(; element != sentinel && element->value < hi; element = element->link[0].next){
+		batch[n++] = element->value;
+		if (n == SKIPLIST_BATCH_KEYS){
+			keys_aggregate(batch, n, aggregate);
+			n = 0;
+		}
 	}
-	l->rng = rng_initialize(0x7FFFFFFF, nblevels);
+	keys_aggregate(batch, n, aggregate);
+}
 
-	return l;
+/*-----SkipList Set algebra------*/
+
+typedef enum e_SetOperation{SET_UNION, SET_INTERSECTION, SET_DIFFERENCE} SetOperation;
+
+/* Gallop : the first tower whose value is greater than or equal to value, from a tower lower than value or the
+   sentinel. Climb while the successor on the top level of the tower is still lower than value, then descend from
+   there : each step on the top level reaches a tower at least as high, O(log k) for a tower k positions further. */
+Node* skip_to(const SkipList* d, Node* node, int value){
+	Node* sentinel = d->sentinel;
+	int top = (node == sentinel ? d->level : node->node_level) - 1;
+	Node* next = node->link[top].next;
+	while (next != sentinel && next->value < value){
+		node = next;
+		top = node->node_level - 1;
+		next = node->link[top].next;
+	}
+	for (int level = top-1; level >= 0; --level){
+		next = node->link[level].next;
+		while (next != sentinel && next->value < value){
+			node = next;
+			next = node->link[level].next;
+		}
+	}
+	return node->link[0].next;
 }
 
-Node** node_array_create(SkipList*d, int value){
-	Node** node_array;
-	int level = rng_get_value(&d->rng) + 1;
-	node_array = malloc(level*sizeof(Node*));
-	if (!node_array){
-		fprintf(stderr, "Failed to allocated memory for a new node array\n");
+/* Append a tower of value to the list d being linked, as high as for an insert at the end of the list. */
+void append_value(SkipList* d, TailLinks* t, int value){
+	tail_links_append(t, node_create(d, value));
+	if (d->adaptive){
+		rng_set_upper_bound(&d->rng, (unsigned int)adaptive_levels(t->size));
 	}
-	
-	for (int i = 0; i < level; i++){
-		node_array[i] = malloc(sizeof(Node));
+}
+
+/* Merge the level 0 chains of a and b, appending the ascending values of a op b to d.
+   The runs of a or b that cannot reach the result are skipped by galloping. */
+void merge_values(const SkipList* a, const SkipList* b, SetOperation op, SkipList* d, TailLinks* t){
+	Node* x = a->sentinel->link[0].next;
+	Node* y = b->sentinel->link[0].next;
+	while (x != a->sentinel && y != b->sentinel){
+		if (x->value < y->value){
+			if (op == SET_INTERSECTION){
+				x = skip_to(a, x, y->value);
+			}else{
+				append_value(d, t, x->value);
+				x = x->link[0].next;
+			}
+		}else if (y->value < x->value){
+			if (op == SET_UNION){
+				append_value(d, t, y->value);
+				y = y->link[0].next;
+			}else{
+				y = skip_to(b, y, x->value);
+			}
+		}else{
+			if (op != SET_DIFFERENCE){
+				append_value(d, t, x->value);
+			}
+			x = x->link[0].next;
+			y = y->link[0].next;
+		}
 	}
-	
-	for (int i = 0; i < level; i++){
-		node_array[i]->value = value;
-		node_array[i]->node_level = level;
+	for (; op != SET_INTERSECTION && x != a->sentinel; x = x->link[0].next){
+		append_value(d, t, x->value);
+	}
+	for (; op == SET_UNION && y != b->sentinel; y = y->link[0].next){
+		append_value(d, t, y->value);
 	}
-	return node_array;
-	
 }
 
+/* New list holding a op b, with the levels, the allocator and the random generator of a. */
+SkipList* set_operation(const SkipList* a, const SkipList* b, SetOperation op){
+	SkipList* d = skiplist_create_with_allocator(a->adaptive ? 0 : a->max_level, a->arena ? ARENA_ALLOCATOR : MALLOC_ALLOCATOR);
+	skiplist_set_generator(d, a->rng.generator);
+	TailLinks t;
+	tail_links_start(d, &t, d->max_level);
+	merge_values(a, b, op, d, &t);
+	tail_links_close(d, &t);
+	COUNT(d, nb_inserts, d->size);
+	return d;
+}
 
-void delete_node_array(Node*** ptrToArrayOfPtrNode, SkipList* l){
-	Node** to_delete = *ptrToArrayOfPtrNode;
-	// iterate through each level of the node array of to_delete
-	int node_level = to_delete[0]->node_level;
-	for (int i = 0; i < node_level; i++){
-		Node** prev_node = (to_delete[i]->prev);
-		Node** next_node = (to_delete[i]->next);
-		prev_node[i]->next = next_node;
-		next_node[i]->prev = prev_node;
-	}
-	for (int i = 0; i < node_level; i++)
-	{
-		free(to_delete[i]);
+SkipList* skiplist_union(const SkipList* a, const SkipList* b){
+	return set_operation(a, b, SET_UNION);
+}
+
+SkipList* skiplist_intersect(const SkipList* a, const SkipList* b){
+	return set_operation(a, b, SET_INTERSECTION);
+}
+
+SkipList* skiplist_difference(const SkipList* a, const SkipList* b){
+	return set_operation(a, b, SET_DIFFERENCE);
+}
+
+/* Empty a list whose towers were moved or freed. */
+void clear_list(SkipList* d){
+	Node* sentinel = d->sentinel;
+	sentinel->link[0].next = sentinel;
+	sentinel->link[0].prev = sentinel;
+	sentinel->link[0].width = 1;
+	d->level = 1;
+	d->size = 0;
+	update_height_bound(d);
+}
+
+/* Move the values of b from its first one not lower than key to a, one by one : the snapshots of a and b record
+   them as inserted in a and removed from b. */
+void move_values(SkipList* a, SkipList* b, int key){
+	unsigned int nb_operations = 0;
+	Node* node = find_predecessors(b, key, NULL, NULL, &nb_operations)->link[0].next;
+	while (node != b->sentinel){
+		Node* next = node->link[0].next;
+		int value = node->value;
+		skiplist_insert(a, value);
+		skiplist_remove(b, value);
+		node = next;
 	}
-	free(to_delete);
-	*ptrToArrayOfPtrNode = NULL;
-	l->size -=1;
+}
 
+SkipList* skiplist_union_with(SkipList* a, SkipList* b){
+	assert(a != b);
+	// the towers of a list read through snapshots stay in place
+	if (has_live_snapshots(a) || has_live_snapshots(b)){
+		move_values(a, b, INT_MIN);
+		return a;
+	}
+	// the towers of b move to a only when both are allocated by malloc : an arena frees its slabs at once
+	bool splice = !a->arena && !b->arena;
+	Node* x = a->sentinel->link[0].next;
+	Node* y = b->sentinel->link[0].next;
+	TailLinks t;
+	tail_links_start(a, &t, a->max_level);
+	while (x != a->sentinel || y != b->sentinel){
+		Node* node;
+		if (y == b->sentinel || (x != a->sentinel && x->value <= y->value)){
+			node = x;
+			x = x->link[0].next;
+			if (y != b->sentinel && y->value == node->value){
+				Node* duplicate = y;
+				y = y->link[0].next;
+				node_free(b, duplicate);
+				COUNT(a, nb_duplicates, 1);
+			}
+		}else{
+			node = y;
+			y = y->link[0].next;
+			if (!splice || node->node_level > a->max_level){
+				Node* copy = node_create_with_level(a, node->value, node->node_level < a->max_level ? node->node_level : a->max_level);
+				node_free(b, node);
+				node = copy;
+			}
+			COUNT(a, nb_inserts, 1);
+		}
+		tail_links_append(&t, node);
+	}
+	tail_links_close(a, &t);
+	COUNT(b, nb_removes, b->size);
+	clear_list(b);
+	update_height_bound(a);
+	return a;
 }
 
-void skiplist_delete(SkipList** d) {
-	SkipList* l = *d;
-	Node** my_sentinel = l->sentinel;
-	while (my_sentinel[0]->next[0]->value != -1){
-		Node** to_delete = my_sentinel[0]->next;
-		// iterate through each level of the node array of to_delete
-		int node_level = to_delete[0]->node_level;
-		for (int i = 0; i < node_level; i++){
-			Node** prev_node = (to_delete[i]->prev);
-			Node** next_node = (to_delete[i]->next);
-			prev_node[i]->next = next_node;
-			next_node[i]->prev = prev_node;
-		}
-		for (int i = 0; i < node_level; i++){
-			free(to_delete[i]);
+/* Keep in a the towers whose value is in b when common is set, or not in b otherwise, and free the others.
+   The runs of b before the next tower of a are skipped by galloping. */
+SkipList* filter_with(SkipList* a, const SkipList* b, bool common){
+	assert(a != b);
+	Node* y = b->sentinel->link[0].next;
+	if (has_live_snapshots(a)){
+		// the towers of a list read through snapshots are removed one by one
+		for (Node* x = a->sentinel->link[0].next; x != a->sentinel; ){
+			Node* next = x->link[0].next;
+			if (y != b->sentinel && y->value < x->value){
+				y = skip_to(b, y, x->value);
+			}
+			if ((y != b->sentinel && y->value == x->value) != common){
+				skiplist_remove(a, x->value);
+			}
+			x = next;
 		}
-		free(to_delete);
-		
+		return a;
 	}
-	free(l);
-	*d = NULL;
+	TailLinks t;
+	tail_links_start(a, &t, a->max_level);
+	for (Node* x = a->sentinel->link[0].next; x != a->sentinel; ){
+		Node* next = x->link[0].next;
+		if (y != b->sentinel && y->value < x->value){
+			y = skip_to(b, y, x->value);
+		}
+		if ((y != b->sentinel && y->value == x->value) == common){
+			tail_links_append(&t, x);
+		}else{
+			node_free(a, x);
+			COUNT(a, nb_removes, 1);
+		}
+		x = next;
+	}
+	tail_links_close(a, &t);
+	update_height_bound(a);
+	return a;
+}
 
+SkipList* skiplist_intersect_with(SkipList* a, const SkipList* b){
+	return filter_with(a, b, true);
 }
 
-unsigned int skiplist_size(const SkipList *d){
-	return d->size;
+SkipList* skiplist_difference_with(SkipList* a, const SkipList* b){
+	return filter_with(a, b, false);
 }
 
-int skiplist_at(const SkipList *d, unsigned int i){
-	Node** current_node = d->sentinel;
+/*-----SkipList Split and concatenation------*/
 
-	for (unsigned int pos = 0; pos < i; pos++)
-	{
-		current_node = current_node[0]->next;
+/* Resume linking the towers of d after its last tower on each level. */
+void tail_links_resume(SkipList* d, TailLinks* t){
+	Node* sentinel = d->sentinel;
+	for (int i = 0; i < d->max_level; i++){
+		t->tail[i] = i < d->level ? sentinel->link[i].prev : sentinel;
+		t->tail_pos[i] = i < d->level ? d->size + 1 - t->tail[i]->link[i].width : 0;
 	}
-	return current_node[0]->value;
+	t->size = d->size;
+	t->levels = d->max_level;
 }
 
+/* Link after the towers of d copies of the towers from first to end excluded, allocated by owner : each copy is
+   as high as d allows and each tower is freed by owner once copied. */
+void append_copies(SkipList* d, TailLinks* t, SkipList* owner, Node* first, Node* end){
+	for (Node* node = first; node != end; ){
+		Node* next = node->link[0].next;
+		int level = node->node_level < d->max_level ? node->node_level : d->max_level;
+		Node* copy = node_create_with_level(d, node->value, level);
+		node_free(owner, node);
+		tail_links_append(t, copy);
+		node = next;
+	}
+}
 
-void skiplist_map(const SkipList* d, ScanOperator f, void *user_data){
-	Node** sentinel = d->sentinel;
-	for(Node** element = sentinel[0]->next; element != d->sentinel; element = element[0]->next){
-		f(element[0]->value, user_data);
+void skiplist_split(SkipList* d, int key, SkipList** left, SkipList** right){
+	Node* update[d->max_level];
+	unsigned int rank[d->max_level];
+	unsigned int nb_operations = 0;
+	find_predecessors(d, key, update, rank, &nb_operations);
+	SkipList* r = skiplist_create_with_allocator(d->adaptive ? 0 : d->max_level, d->arena ? ARENA_ALLOCATOR : MALLOC_ALLOCATOR);
+	skiplist_set_generator(r, d->rng.generator);
+	*left = d;
+	*right = r;
+	if (has_live_snapshots(d)){
+		// the towers of a list read through snapshots stay in place
+		move_values(r, d, key);
+		return;
+	}
+	Node* sentinel = d->sentinel;
+	Node* r_sentinel = r->sentinel;
+	unsigned int size = rank[0];
+	r->size = d->size - size;
+	// cut each level after the predecessor of key : the towers after it move to r, at their position minus size
+	for (int i = 0; i < d->level; i++){
+		Node* prev_node = update[i];
+		Node* next_node = prev_node->link[i].next;
+		if (next_node == sentinel){
+			r_sentinel->link[i].next = r_sentinel;
+			r_sentinel->link[i].prev = r_sentinel;
+			r_sentinel->link[i].width = r->size + 1;
+		}else{
+			Node* last = sentinel->link[i].prev;
+			r_sentinel->link[i].next = next_node;
+			r_sentinel->link[i].width = rank[i] + prev_node->link[i].width - size;
+			next_node->link[i].prev = r_sentinel;
+			r_sentinel->link[i].prev = last;
+			last->link[i].next = r_sentinel;
+		}
+		prev_node->link[i].next = sentinel;
+		prev_node->link[i].width = size + 1 - rank[i];
+		sentinel->link[i].prev = prev_node;
+	}
+	r->level = d->level;
+	d->size = size;
+	lower_level(d);
+	lower_level(r);
+	if (d->arena){
+		// the towers of r live in the slabs of d
+		TailLinks t;
+		tail_links_start(r, &t, r->max_level);
+		append_copies(r, &t, d, r_sentinel->link[0].next, r_sentinel);
+		tail_links_close(r, &t);
 	}
+	update_height_bound(d);
+	update_height_bound(r);
+	COUNT(d, nb_removes, r->size);
+	COUNT(r, nb_inserts, r->size);
 }
 
-Node** find_next_node(Node**sentinel, Node** node, int* current_level){
-	Node** next_node;
-	// if there is a next node
-	if (node[*current_level]->next != sentinel){
-		printf("case 1\n");
-		next_node = node[*current_level]->next;
+SkipList* skiplist_concat(SkipList* a, SkipList* b){
+	assert(a != b);
+	assert(a->size == 0 || b->size == 0 || a->sentinel->link[0].prev->value < b->sentinel->link[0].next->value);
+	if (has_live_snapshots(a) || has_live_snapshots(b)){
+		// the towers of a list read through snapshots stay in place
+		move_values(a, b, INT_MIN);
+		return a;
 	}
-	// if node points to sentinel and node level != 0
-	// return first node of a lower level
-	if ((node[*current_level]->next == sentinel)&&*current_level>0)
-	{
-		printf("case 2\n");
-		*current_level -= 1;
-		next_node = sentinel[*current_level]->next;
+	Node* sentinel = a->sentinel;
+	Node* b_sentinel = b->sentinel;
+	COUNT(a, nb_inserts, b->size);
+	COUNT(b, nb_removes, b->size);
+	if (a->arena || b->arena || b->level > a->max_level){
+		// the towers of b must be allocated as those of a
+		TailLinks t;
+		tail_links_resume(a, &t);
+		append_copies(a, &t, b, b_sentinel->link[0].next, b_sentinel);
+		tail_links_close(a, &t);
+	}else{
+		Node* update[a->max_level];
+		unsigned int rank[a->max_level];
+		int level = a->level > b->level ? a->level : b->level;
+		raise_level(a, level, update, rank);
+		// join each level after the last tower of a : the towers of b follow, at their position plus the size of a
+		for (int i = 0; i < level; i++){
+			Node* last = sentinel->link[i].prev;
+			if (i >= b->level || b_sentinel->link[i].next == b_sentinel){
+				last->link[i].width += b->size;
+			}else{
+				Node* first = b_sentinel->link[i].next;
+				last->link[i].width += b_sentinel->link[i].width - 1;
+				last->link[i].next = first;
+				first->link[i].prev = last;
+				b_sentinel->link[i].prev->link[i].next = sentinel;
+				sentinel->link[i].prev = b_sentinel->link[i].prev;
+			}
+		}
+		a->size += b->size;
+	}
+	clear_list(b);
+	update_height_bound(a);
+	return a;
+}
+
+/*-----SkipList Snapshots------*/
+
+SkipListSnapshot skiplist_snapshot(SkipList* d){
+	if (!d->versions){
+		Versions* versions = malloc(sizeof(Versions));
+		if (!versions){
+			fprintf(stderr, "Memory allocation failed for the snapshots of a SkipList\n");
+			exit(1);
+		}
+		pthread_rwlock_init(&versions->lock, NULL);
+		versions->live = NULL;
+		versions->retired = NULL;
+		versions->last_id = 0;
+		versions->deleted = false;
+		d->versions = versions;
 	}
-	else{ // reaching the end of the list at level 0
-		printf("case 1\n");
-		next_node = node;
+	Version* version = malloc(sizeof(Version));
+	if (!version){
+		fprintf(stderr, "Memory allocation failed for SkipListSnapshot\n");
+		exit(1);
 	}
-	return next_node;
+	version->added = skiplist_create(0);
+	version->removed = skiplist_create(0);
+	// the readers of released snapshots may be looking for theirs
+	pthread_rwlock_wrlock(&d->versions->lock);
+	version->id = ++d->versions->last_id;
+	version->next = d->versions->live;
+	__atomic_store_n(&d->versions->live, version, __ATOMIC_RELEASE);
+	pthread_rwlock_unlock(&d->versions->lock);
+	return (SkipListSnapshot){d, version->id};
 }
 
+/* Live snapshot of s, NULL if s was released, with the lock of the snapshots held for reading when found. */
+Version* lock_version(const SkipListSnapshot* s){
+	if (!s || !s->list || !s->list->versions){
+		return NULL;
+	}
+	Versions* versions = s->list->versions;
+	pthread_rwlock_rdlock(&versions->lock);
+	Version* version = versions->live;
+	while (version && version->id != s->version){
+		version = version->next;
+	}
+	if (!version){
+		pthread_rwlock_unlock(&versions->lock);
+	}
+	return version;
+}
 
-bool node_has_no_follower(Node** node){
-	int node_level = node[0]->node_level;
-	for (int i = 0; i < node_level; i++){
-		if (node[i]->next[i]->value != -1){
-			return false;
+void unlock_version(const SkipListSnapshot* s){
+	pthread_rwlock_unlock(&s->list->versions->lock);
+}
+
+bool skiplist_snapshot_release(SkipListSnapshot* s){
+	if (!s || !s->list || !s->list->versions){
+		return false;
+	}
+	SkipList* d = s->list;
+	Versions* versions = d->versions;
+	pthread_rwlock_wrlock(&versions->lock);
+	Version** link = &versions->live;
+	while (*link && (*link)->id != s->version){
+		link = &(*link)->next;
+	}
+	Version* version = *link;
+	if (!version){
+		pthread_rwlock_unlock(&versions->lock);
+		return false;
+	}
+	bool orphan = false;
+	if (link == &versions->live && !version->next){
+		// no iterator may stand on a retired tower any more. They are freed before the writer may see that no
+		// snapshot is live and stop taking the lock.
+		while (versions->retired){
+			Node* node = versions->retired;
+			versions->retired = node->link[0].prev;
+			node_free(d, node);
 		}
+		orphan = versions->deleted;
+	}
+	__atomic_store_n(link, version->next, __ATOMIC_RELEASE);
+	pthread_rwlock_unlock(&versions->lock);
+	skiplist_delete(&version->added);
+	skiplist_delete(&version->removed);
+	free(version);
+	s->list = NULL;
+	s->version = 0;
+	if (orphan){
+		// the list was deleted by its writer while this snapshot was live
+		skiplist_delete(&d);
 	}
 	return true;
 }
 
-Node** find_prev_node_to_insert(Node** node, int highest_level, int val_to_insert, unsigned int *nboperations){
-	int next_value_of_highest_level = node[highest_level]->next[highest_level]->value;
-	if (next_value_of_highest_level != -1)
-	{
-		*nboperations +=1;
+/* Search without counting : the readers of snapshots do not modify the counters of the lists they read. */
+bool holds_value(const SkipList* d, int value, unsigned int *nb_operations){
+	Node* node = find_predecessors(d, value, NULL, NULL, nb_operations)->link[0].next;
+	return node != d->sentinel && node->value == value;
+}
+
+unsigned int snapshot_size(const SkipList* d, const Version* version){
+	return d->size - version->added->size + version->removed->size;
+}
+
+bool skiplist_snapshot_size(const SkipListSnapshot* s, unsigned int* size){
+	Version* version = lock_version(s);
+	if (!version){
+		return false;
 	}
-	
-	if (next_value_of_highest_level >= val_to_insert){
-		if (highest_level != 0){
-			return find_prev_node_to_insert(node, highest_level-1, val_to_insert, nboperations);
+	*size = snapshot_size(s->list, version);
+	unlock_version(s);
+	return true;
+}
+
+bool skiplist_snapshot_search(const SkipListSnapshot* s, int value, bool* found, unsigned int *nb_operations){
+	Version* version = lock_version(s);
+	if (!version){
+		return false;
+	}
+	*found = holds_value(version->removed, value, nb_operations)
+		|| (holds_value(s->list, value, nb_operations) && !holds_value(version->added, value, nb_operations));
+	unlock_version(s);
+	return true;
+}
+
+/* Number of values of d lower than value : the position of their last one. */
+unsigned int count_lower(const SkipList* d, int value){
+	Node* update[d->max_level];
+	unsigned int rank[d->max_level];
+	unsigned int nb_operations = 0;
+	find_predecessors(d, value, update, rank, &nb_operations);
+	return rank[0];
+}
+
+/* Number of values of a snapshot of d lower than or equal to value. */
+unsigned int snapshot_count_not_greater(const SkipList* d, const Version* version, long long int value){
+	if (value >= INT_MAX){
+		return snapshot_size(d, version);
+	}
+	int bound = (int)(value + 1);
+	return count_lower(d, bound) - count_lower(version->added, bound) + count_lower(version->removed, bound);
+}
+
+bool skiplist_snapshot_at(const SkipListSnapshot* s, unsigned int i, int* value){
+	Version* version = lock_version(s);
+	if (!version){
+		return false;
+	}
+	bool found = i < snapshot_size(s->list, version);
+	// the ith value is the lowest one with more than i values lower than or equal to it
+	long long int lo = INT_MIN;
+	long long int hi = INT_MAX;
+	while (found && lo < hi){
+		long long int mid = lo + (hi - lo) / 2;
+		if (snapshot_count_not_greater(s->list, version, mid) > i){
+			hi = mid;
 		}else{
-			return node;}
+			lo = mid + 1;
+		}
+	}
+	unlock_version(s);
+	if (found){
+		*value = (int)lo;
+	}
+	return found;
+}
+
+/* Put the iterator on the first value of its snapshot, or on the first one greater than its value when next is set.
+   It is the lowest of the next tower of the list not added since the snapshot, and of the next value removed since
+   the snapshot. The tower of the iterator may have been retired since : a value removed then inserted again may
+   follow it in the list but not in its links, so the walk starts again from a search in the list. */
+void snapshot_iterator_move(SkipListSnapshotIterator* it, const Version* version, bool next){
+	const SkipList* d = it->snapshot.list;
+	Node* sentinel = d->sentinel;
+	Node* node = it->node;
+	int last = it->value;
+	unsigned int nb_operations = 0;
+	if (node != sentinel && node->link[0].width == 0){
+		node = find_predecessors(d, last, NULL, NULL, &nb_operations)->link[0].next;
+	}
+	while (node != sentinel && ((next && node->value <= last)
+			|| (version->added->size && holds_value(version->added, node->value, &nb_operations)))){
+		node = node->link[0].next;
+	}
+	it->node = node;
+	it->end = node == sentinel;
+	if (!it->end){
+		it->value = node->value;
+	}
+	if (version->removed->size && (!next || last < INT_MAX)){
+		Node* removed = find_predecessors(version->removed, next ? last + 1 : INT_MIN, NULL, NULL, &nb_operations)->link[0].next;
+		if (removed != version->removed->sentinel && (it->end || removed->value < it->value)){
+			it->value = removed->value;
+			it->end = false;
+		}
+	}
+}
+
+bool skiplist_snapshot_iterator_init(SkipListSnapshotIterator* it, const SkipListSnapshot* s){
+	it->snapshot = s ? *s : (SkipListSnapshot){NULL, 0};
+	it->node = NULL;
+	it->value = INT_MIN;
+	it->end = true;
+	Version* version = lock_version(s);
+	if (!version){
+		return false;
+	}
+	it->node = s->list->sentinel->link[0].next;
+	snapshot_iterator_move(it, version, false);
+	unlock_version(s);
+	return true;
+}
+
+bool skiplist_snapshot_iterator_end(const SkipListSnapshotIterator* it){
+	return it->end;
+}
+
+bool skiplist_snapshot_iterator_next(SkipListSnapshotIterator* it){
+	if (it->end){
+		return true;
+	}
+	Version* version = lock_version(&it->snapshot);
+	if (!version){
+		it->end = true;
+		return false;
+	}
+	snapshot_iterator_move(it, version, true);
+	unlock_version(&it->snapshot);
+	return true;
+}
+
+int skiplist_snapshot_iterator_value(const SkipListSnapshotIterator* it){
+	return it->value;
+}
+
+bool skiplist_snapshot_map(const SkipListSnapshot* s, ScanOperator f, void *environment){
+	SkipListSnapshotIterator it;
+	bool live = skiplist_snapshot_iterator_init(&it, s);
+	while (live && !skiplist_snapshot_iterator_end(&it)){
+		// f is applied without the lock : it may modify the list
+		f(it.value, environment);
+		live = skiplist_snapshot_iterator_next(&it);
+	}
+	return live;
+}
+
+/*-----SkipList Statistics------*/
+
+void skiplist_stats(const SkipList* d, SkipListStats* stats){
+	Node* sentinel = d->sentinel;
+	int levels = d->level;
+	*stats = (SkipListStats){0};
+	stats->size = d->size;
+	stats->max_level = d->max_level;
+	stats->level = levels;
+	// last[i] is the last tower of level i met so far, count[i] the number of towers of level i up to it
+	// and last_below[i] its number on level i-1
+	Node* last[levels];
+	unsigned int count[levels];
+	unsigned int last_below[levels];
+	for (int i = 0; i < levels; i++){
+		last[i] = sentinel;
+		count[i] = 0;
+		last_below[i] = 0;
 	}
-	else{   
-		if (node_has_no_follower(node)){// all level points to sentinel
-			return node;
+	unsigned long long int total_path = 0;
+	size_t tower_bytes = 0;
+	for (Node* node = sentinel->link[0].next; node != sentinel; node = node->link[0].next){
+		// the search of the value of node moves on level i from last[i+1] to last[i], then tests the successor of last[i]
+		unsigned int path = 0;
+		for (int i = levels-1; i >= 0; --i){
+			path += count[i] - (i+1 < levels ? last_below[i+1] : 0);
+			path += last[i]->link[i].next != sentinel;
 		}
-		// If highest level > 0 and  points to sentinel THEN search lower level
-		if (highest_level > 0 && next_value_of_highest_level == -1){
-			return find_prev_node_to_insert(node, highest_level-1,val_to_insert, nboperations);
+		total_path += path;
+		if (path > stats->max_search_path){
+			stats->max_search_path = path;
 		}
-		// If highest level does not point to sentinel
-		else{ 
-			return find_prev_node_to_insert(node[highest_level]->next, highest_level, val_to_insert, nboperations);
+		for (int i = 0; i < node->node_level; i++){
+			count[i] += 1;
+			last[i] = node;
+			last_below[i] = i > 0 ? count[i-1] : 0;
 		}
+		int height = node->node_level < SKIPLIST_MAX_LEVEL ? node->node_level : SKIPLIST_MAX_LEVEL;
+		stats->height_histogram[height-1] += 1;
+		tower_bytes += node_size(node->node_level);
 	}
+	for (int i = 0; i < levels && i < SKIPLIST_MAX_LEVEL; i++){
+		stats->nodes_per_level[i] = count[i];
+	}
+	stats->average_search_path = d->size ? (double)total_path / d->size : 0;
+	stats->bytes_allocated = sizeof(SkipList) + node_size(d->max_level);
+	if (d->arena){
+		// the towers live in the slabs, with the recycled and not yet used towers
+		stats->bytes_allocated += sizeof(Arena) + (size_t)d->max_level*sizeof(SizeClass) + d->arena->bytes;
+	}else{
+		stats->bytes_allocated += tower_bytes;
+	}
+#ifdef SKIPLIST_STATS
+	stats->counters_enabled = true;
+	stats->nb_inserts = d->counters.nb_inserts;
+	stats->nb_removes = d->counters.nb_removes;
+	stats->nb_duplicates = d->counters.nb_duplicates;
+	stats->nb_searches = d->counters.nb_searches;
+	stats->nb_search_operations = d->counters.nb_search_operations;
+	stats->max_search_operations = d->counters.max_search_operations;
+#endif
 }
 
-void bind_nodes(Node** prev_node, Node** node_to_insert, Node** next_node, int insert_level){
-	//bind to the prev node
-	prev_node[insert_level]->next = node_to_insert;
-	node_to_insert[insert_level]->prev = prev_node;
-	//bind to next node
-	node_to_insert[insert_level]->next = next_node;
-	next_node[insert_level]->prev = node_to_insert;
-}
-
-void bind_arrays_of_nodes(Node**prev_node, Node** node_to_insert){
-	int level = node_to_insert[0]->node_level;
-	for (int i = 0; i < level; i++){
-		if (i <= prev_node[0]->node_level-1){
-			Node** next_node = prev_node[i]->next;
-			bind_nodes(prev_node, node_to_insert, next_node, i);
-		}
-		else{
-			int current_max_level = prev_node[0]->node_level-1;
-			while (current_max_level < i)
-			{
-				prev_node = prev_node[i-1]->prev;
-				current_max_level = prev_node[0]->node_level-1;
+/* Size up to which printbylevel prints the values of each level. */
+#define PRINT_MAX_VALUES 100
+
+void printbylevel(SkipList* d){
+	SkipListStats stats;
+	skiplist_stats(d, &stats);
+	printf("Skiplist of size %u on %d levels out of %d, %lu bytes\n", stats.size, stats.level, stats.max_level, (unsigned long)stats.bytes_allocated);
+	printf("Search path : average %.2f, max %u, log2(n+1) = %.2f\n", stats.average_search_path, stats.max_search_path, log2(stats.size + 1.0));
+	printf("Tower heights :");
+	for (int i = 0; i < SKIPLIST_MAX_LEVEL; i++){
+		if (stats.height_histogram[i]){
+			printf(" %d:%u", i+1, stats.height_histogram[i]);
+		}
+	}
+	printf("\n");
+	if (stats.counters_enabled){
+		printf("Operations : %llu inserts, %llu duplicates, %llu removes, %llu searches of %.2f tested nodes on average, max %u\n",
+			stats.nb_inserts, stats.nb_duplicates, stats.nb_removes, stats.nb_searches,
+			stats.nb_searches ? (double)stats.nb_search_operations / stats.nb_searches : 0, stats.max_search_operations);
+	}
+	for (int level = stats.level-1; level >= 0; --level){
+		printf("Level %d (%u towers)", level, level < SKIPLIST_MAX_LEVEL ? stats.nodes_per_level[level] : 0);
+		if (d->size <= PRINT_MAX_VALUES){
+			printf(" :");
+			for (Node* node = d->sentinel->link[level].next; node != d->sentinel; node = node->link[level].next){
+				printf(" %d", node->value);
 			}
-			Node** next_node = prev_node[i]->next;
-			bind_nodes(prev_node, node_to_insert, next_node, i);
 		}
+		printf("\n");
 	}
 }
 
-bool node_of_same_value(Node** node1, Node** node2){
-	return (node1[0]->value == node2[0]->value);
+/*-----SkipList Persistence------*/
+
+/* Image of a list : a header of IMAGE_HEADER_WORDS little endian 32 bits words, the values in ascending order as
+   little endian 32 bits integers, then the height of each tower on one byte.
+   The header holds the magic number IMAGE_MAGIC ("SKLI"), the version of the format, the number of values,
+   the number of levels (0 for an adaptive list), the random generator, the allocator and two reserved words. */
+#define IMAGE_MAGIC 0x494C4B53
+#define IMAGE_VERSION 1
+#define IMAGE_HEADER_WORDS 8
+#define IMAGE_HEADER_BYTES (4*IMAGE_HEADER_WORDS)
+
+static uint32_t image_read_word(const unsigned char* bytes){
+	return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
 }
 
-SkipList* skiplist_insert(SkipList* d, int value) {
-	Node** new_node = node_array_create(d, value);
-	unsigned int search_number = 0;
-	unsigned int* nboperations = &search_number;
-	Node** prev_node_to_insert = find_prev_node_to_insert(d->sentinel, d->max_level-1, value, nboperations);
-	// Case duplication
-	if (prev_node_to_insert[0]->next[0]->value == value){
-		Node** duplicate_node = prev_node_to_insert[0]->next;
-		delete_node_array(&duplicate_node, d);
-	}
-	bind_arrays_of_nodes(prev_node_to_insert, new_node);
-	d->size +=1;
+static void image_store_word(uint32_t word, unsigned char* bytes){
+	bytes[0] = (unsigned char)word;
+	bytes[1] = (unsigned char)(word >> 8);
+	bytes[2] = (unsigned char)(word >> 16);
+	bytes[3] = (unsigned char)(word >> 24);
+}
+
+static bool host_is_little_endian(void){
+	const uint32_t one = 1;
+	return *(const unsigned char*)&one == 1;
+}
+
+/* Content of an image file, mapped in memory when the system allows it, read otherwise. */
+typedef struct s_ImageFile{
+	unsigned char* data;
+	size_t size;
+	bool mapped;
+} ImageFile;
+
+static bool image_open(const char* path, ImageFile* file){
+#ifndef _WIN32
+	int fd = open(path, O_RDONLY);
+	if (fd < 0){
+		return false;
+	}
+	struct stat status;
+	if (fstat(fd, &status) == 0 && status.st_size > 0){
+		void* data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED){
+			close(fd);
+			file->data = data;
+			file->size = (size_t)status.st_size;
+			file->mapped = true;
+			return true;
+		}
+	}
+	close(fd);
+#endif
+	FILE* input = fopen(path, "rb");
+	if (!input){
+		return false;
+	}
+	fseek(input, 0, SEEK_END);
+	long size = ftell(input);
+	rewind(input);
+	file->data = malloc((size_t)size + 1);
+	if (!file->data){
+		fprintf(stderr, "Memory allocation failed for the image %s\n", path);
+		exit(1);
+	}
+	file->size = fread(file->data, 1, (size_t)size, input);
+	file->mapped = false;
+	fclose(input);
+	return true;
+}
+
+static void image_close(ImageFile* file){
+#ifndef _WIN32
+	if (file->mapped){
+		munmap(file->data, file->size);
+		return;
+	}
+#endif
+	free(file->data);
+}
+
+/* Check the header of an image and its length. Stores the number of values and the number of levels. */
+static bool image_check_header(const ImageFile* file, unsigned int* size, int* nblevels){
+	if (file->size < IMAGE_HEADER_BYTES || image_read_word(file->data) != IMAGE_MAGIC
+		|| image_read_word(file->data + 4) != IMAGE_VERSION){
+		return false;
+	}
+	*size = image_read_word(file->data + 8);
+	*nblevels = (int)image_read_word(file->data + 12);
+	return *nblevels >= 0 && *nblevels <= SKIPLIST_MAX_LEVEL
+		&& image_read_word(file->data + 16) <= RNG_CTZ && image_read_word(file->data + 20) <= ARENA_ALLOCATOR
+		&& (file->size - IMAGE_HEADER_BYTES) / 5 >= *size;
+}
+
+/* Values of an image : read in place on a little endian host, converted into *copy otherwise. */
+static const int* image_values(const ImageFile* file, unsigned int size, int** copy){
+	const unsigned char* bytes = file->data + IMAGE_HEADER_BYTES;
+	*copy = NULL;
+	if (host_is_little_endian()){
+		return (const int*)bytes;
+	}
+	*copy = malloc(((size_t)size + 1) * sizeof(int));
+	if (!*copy){
+		fprintf(stderr, "Memory allocation failed for the values of an image\n");
+		exit(1);
+	}
+	for (unsigned int k = 0; k < size; k++){
+		(*copy)[k] = (int)image_read_word(bytes + 4*(size_t)k);
+	}
+	return *copy;
+}
+
+bool skiplist_save(const SkipList* d, const char* path){
+	FILE* output = fopen(path, "wb");
+	if (!output){
+		return false;
+	}
+	Node* sentinel = d->sentinel;
+	unsigned char header[IMAGE_HEADER_BYTES] = {0};
+	image_store_word(IMAGE_MAGIC, header);
+	image_store_word(IMAGE_VERSION, header + 4);
+	image_store_word(d->size, header + 8);
+	image_store_word(d->adaptive ? 0 : (uint32_t)d->max_level, header + 12);
+	image_store_word(d->rng.generator, header + 16);
+	image_store_word(d->arena ? ARENA_ALLOCATOR : MALLOC_ALLOCATOR, header + 20);
+	bool written = fwrite(header, 1, IMAGE_HEADER_BYTES, output) == IMAGE_HEADER_BYTES;
+	// the values, then the heights, by batches of SKIPLIST_BATCH_KEYS towers
+	unsigned char batch[4*SKIPLIST_BATCH_KEYS];
+	size_t n = 0;
+	for (Node* node = sentinel->link[0].next; node != sentinel; node = node->link[0].next){
+		image_store_word((uint32_t)node->value, batch + 4*n);
+		if (++n == SKIPLIST_BATCH_KEYS){
+			written = written && fwrite(batch, 4, n, output) == n;
+			n = 0;
+		}
+	}
+	written = written && fwrite(batch, 4, n, output) == n;
+	n = 0;
+	for (Node* node = sentinel->link[0].next; node != sentinel; node = node->link[0].next){
+		batch[n] = (unsigned char)node->node_level;
+		if (++n == sizeof(batch)){
+			written = written && fwrite(batch, 1, n, output) == n;
+			n = 0;
+		}
+	}
+	written = written && fwrite(batch, 1, n, output) == n;
+	return fclose(output) == 0 && written;
+}
+
+SkipList* skiplist_load(const char* path){
+	ImageFile file;
+	if (!image_open(path, &file)){
+		return NULL;
+	}
+	SkipList* d = NULL;
+	unsigned int size;
+	int nblevels;
+	if (image_check_header(&file, &size, &nblevels)){
+		int* copy;
+		const int* values = image_values(&file, size, &copy);
+		const unsigned char* heights = file.data + IMAGE_HEADER_BYTES + 4*(size_t)size;
+		int max_height = nblevels ? nblevels : SKIPLIST_MAX_LEVEL;
+		int levels = 1;
+		bool valid = true;
+		for (unsigned int k = 0; k < size && valid; k++){
+			valid = heights[k] >= 1 && heights[k] <= max_height && (k == 0 || values[k-1] < values[k]);
+			levels = heights[k] > levels ? heights[k] : levels;
+		}
+		if (valid){
+			d = skiplist_create_with_allocator(nblevels, (SkipListAllocator)image_read_word(file.data + 20));
+			skiplist_set_generator(d, (RNGGenerator)image_read_word(file.data + 16));
+			link_sorted_values(d, values, size, levels, false, heights);
+			update_height_bound(d);
+			COUNT(d, nb_inserts, size);
+		}
+		free(copy);
+	}
+	image_close(&file);
 	return d;
 }
 
+/* A mapped image : the values are searched in place, by binary search. */
+struct s_MappedSkipList{
+	ImageFile file;
+	const int* values;
+	int* copy;
+	unsigned int size;
+};
 
-bool skiplist_search(const SkipList* d, int value, unsigned int *nb_operations){
-	Node** sentinel = d->sentinel;
-	Node** biggest_prev_node = find_prev_node_to_insert(sentinel, d->max_level-1, value, nb_operations);
-	if (biggest_prev_node[0]->next[0]->value == value){
-		return true;
+MappedSkipList* skiplist_open_mapped(const char* path){
+	ImageFile file;
+	if (!image_open(path, &file)){
+		return NULL;
 	}
-	return false;
+	unsigned int size;
+	int nblevels;
+	if (!image_check_header(&file, &size, &nblevels)){
+		image_close(&file);
+		return NULL;
+	}
+	MappedSkipList* d = malloc(sizeof(MappedSkipList));
+	if (!d){
+		fprintf(stderr, "Memory allocation failed for MappedSkipList\n");
+		exit(1);
+	}
+	d->file = file;
+	d->size = size;
+	d->values = image_values(&d->file, size, &d->copy);
+	return d;
 }
 
-SkipList* skiplist_remove(SkipList* d, int value){
-	Node** sentinel = d->sentinel;
+void mapped_skiplist_close(MappedSkipList** d){
+	image_close(&(*d)->file);
+	free((*d)->copy);
+	free(*d);
+	*d = NULL;
+}
+
+unsigned int mapped_skiplist_size(const MappedSkipList* d){
+	return d->size;
+}
+
+int mapped_skiplist_at(const MappedSkipList* d, unsigned int i){
+	return d->values[i];
+}
+
+/* Position of the first value greater than or equal to value. Each probed value counts as one operation. */
+static unsigned int mapped_lower_bound(const MappedSkipList* d, int value, unsigned int* nb_operations){
+	unsigned int first = 0;
+	unsigned int n = d->size;
+	while (n > 0){
+		unsigned int half = n / 2;
+		++(*nb_operations);
+		if (d->values[first + half] < value){
+			first += half + 1;
+			n -= half + 1;
+		}else{
+			n = half;
+		}
+	}
+	return first;
+}
+
+bool mapped_skiplist_search(const MappedSkipList* d, int value, unsigned int *nb_operations){
+	*nb_operations = 0;
+	unsigned int i = mapped_lower_bound(d, value, nb_operations);
+	return i < d->size && d->values[i] == value;
+}
+
+int mapped_skiplist_rank(const MappedSkipList* d, int value){
 	unsigned int nb_operations = 0;
-	//printf("Finding prev_node\n");
+	unsigned int i = mapped_lower_bound(d, value, &nb_operations);
+	return i < d->size && d->values[i] == value ? (int)i : -1;
+}
 
-	Node** biggest_prev_node = find_prev_node_to_insert(sentinel, d->max_level-1, value, &nb_operations);
-	//printf("found prev_node\n");
-	Node** to_remove = NULL;
-	// If found the node
-	if (biggest_prev_node[0]->next[0]->value == value){
-		
-		to_remove = biggest_prev_node[0]->next;
-		//printf("Found %i in the list\n", to_remove[0]->value);
-		delete_node_array(&to_remove, d);
+void mapped_skiplist_map(const MappedSkipList* d, ScanOperator f, void *user_data){
+	for (unsigned int i = 0; i < d->size; i++){
+		f(d->values[i], user_data);
 	}
-	//printf("Not Found %i in the list\n", value);
-	return d;
+}
+
+void mapped_skiplist_aggregate_range(const MappedSkipList* d, int lo, int hi, KeyAggregate* aggregate){
+	size_t first = keys_lower_bound(d->values, d->size, lo);
+	size_t last = lo < hi ? first + keys_lower_bound(d->values + first, d->size - first, hi) : first;
+	keys_aggregate(d->values + first, last - first, aggregate);
 }
 
 /*-----SkipList Iterator------*/
-struct s_SkipListIterator{
-	SkipList* collection;
-	SkipListIterator* (*begin) (SkipListIterator*);
-	SkipListIterator* (*next) (SkipListIterator*);
-	Node** current;
-	IteratorDirection direction;
-};
 
+/* A forward iterator records in predecessors[i] the last tower before current on level i, for
+   skiplist_iterator_erase. A backward iterator does not record them. */
 SkipListIterator* skiplist_iterator_begin(SkipListIterator* it){
 	SkipList* l = it->collection;
-	Node** sentinel = l->sentinel;
+	Node* sentinel = l->sentinel;
 	if (it->direction == FORWARD_ITERATOR)
 	{
-		it->current = sentinel[0]->next;
+		it->current = sentinel->link[0].next;
+		for (int i = 0; i < l->level; i++){
+			it->predecessors[i] = sentinel;
+		}
 	}else{
-		it->current = sentinel[0]->prev;
+		it->current = sentinel->link[0].prev;
 	}
 	return it;
 }
 SkipListIterator* skiplist_iterator_next(SkipListIterator* it){
 	if(it->direction == FORWARD_ITERATOR){
-		it->current = it->current[0]->next;
+		for (int i = 0; i < it->current->node_level; i++){
+			it->predecessors[i] = it->current;
+		}
+		it->current = it->current->link[0].next;
 	}else {
-		it->current = it->current[0]->prev;
+		it->current = it->current->link[0].prev;
 	}
 	return it;
 }
 
 bool skiplist_iterator_end(SkipListIterator* it){
 	SkipList* l = it->collection;
-	Node** sentinel = l->sentinel;
-	if (it->current == sentinel)
+	if (it->current == l->sentinel)
 	{
 		return true;
 	}
@@ -312,49 +2045,78 @@ bool skiplist_iterator_end(SkipListIterator* it){
 	
 }
 
+SkipListIterator* skiplist_iterator_seek(SkipListIterator* it, int value){
+	SkipList* l = it->collection;
+	unsigned int nb_operations = 0;
+	unsigned int rank[l->max_level];
+	Node* prev_node;
+	if (it->direction == FORWARD_ITERATOR){
+		prev_node = find_predecessors(l, value, it->predecessors, rank, &nb_operations);
+	}else{
+		prev_node = find_predecessors(l, value, NULL, NULL, &nb_operations);
+	}
+	Node* next_node = prev_node->link[0].next;
+	if (it->direction == FORWARD_ITERATOR || (next_node != l->sentinel && next_node->value == value)){
+		it->current = next_node;
+	}else{
+		it->current = prev_node;
+	}
+	return it;
+}
+
 int skiplist_iterator_value(SkipListIterator* it){
-	return it->current[0]->value;
+	return it->current->value;
+}
+
+SkipListIterator* skiplist_iterator_erase(SkipListIterator* it){
+	SkipList* d = it->collection;
+	Node* node = it->current;
+	if (it->direction == FORWARD_ITERATOR){
+		// the predecessors of the erased tower become those of its successor
+		it->current = node->link[0].next;
+		delete_node(&node, it->predecessors, d);
+	}else{
+		Node* update[d->max_level];
+		skiplist_iterator_next(it);
+		upper_predecessors(d, node, update);
+		delete_node(&node, update, d);
+	}
+	return it;
+}
+
+SkipListIterator* skiplist_iterator_init(SkipListIterator* it, SkipList* d, IteratorDirection direction){
+	it->collection = d;
+	it->direction = direction;
+	return skiplist_iterator_begin(it);
 }
 
 SkipListIterator* skiplist_iterator_create(SkipList* d, IteratorDirection direction){
 	SkipListIterator* t = malloc(sizeof(SkipListIterator));
-	t->collection = d;
-	t->begin = skiplist_iterator_begin;
-	t->direction = direction;
-	t->next = skiplist_iterator_next;
-	if (direction == FORWARD_ITERATOR)
-	{
-		t->current = d->sentinel[0]->next;
-	}else{
-		t->current = d->sentinel[0]->prev;
+	if (!t){
+		fprintf(stderr, "Memory allocation failed for SkipListIterator\n");
+		exit(1);
 	}
-	return t;
+	return skiplist_iterator_init(t, d, direction);
+}
+
+void skiplist_iterator_delete(SkipListIterator** it){
+	free(*it);
+	*it = NULL;
 }
 
 bool search_iterate_on_skiplist ( SkipList * d, IteratorDirection direction, int val, unsigned int* nbOperations ) {
-SkipListIterator * e = skiplist_iterator_create (d , direction) ;
-	for ( e = skiplist_iterator_begin ( e);! skiplist_iterator_end (e ); e = skiplist_iterator_next (e)){
+	SkipListIterator e;
+	for (skiplist_iterator_init(&e, d, direction); !skiplist_iterator_end(&e); skiplist_iterator_next(&e)){
 		(*nbOperations) ++;
-		if (skiplist_iterator_value(e) == val){
+		if (skiplist_iterator_value(&e) == val){
 			return true;
-			free(e); 
-		}	
+		}
 	}
-	free(e);
 	return false;
 }
-/*
-void skiplist_map(const SkipList* d, ScanOperator f, void *user_data){
-	Node** sentinel = d->sentinel;
-	for(Node** element = sentinel[0]->next; element != d->sentinel; element = element[0]->next){
-		f(element[0]->value, user_data);
-	}
-}
-*/
 void iterate_on_skiplist ( SkipList * d, IteratorDirection direction,  ScanOperator f, void* environment){
-	SkipListIterator * e = skiplist_iterator_create (d , direction) ;
-	for ( e = skiplist_iterator_begin ( e);! skiplist_iterator_end (e ); e = skiplist_iterator_next (e)){
-		f(skiplist_iterator_value(e), environment);	
+	SkipListIterator e;
+	for (skiplist_iterator_init(&e, d, direction); !skiplist_iterator_end(&e); skiplist_iterator_next(&e)){
+		f(skiplist_iterator_value(&e), environment);
 	}
-	free(e);
-}
\ No newline at end of file
+}
@@ -4,6 +4,9 @@
 
 #include <stdio.h>
 
+#include "rng.h"
+#include "keykernels.h"
+
 /**
  *	@defgroup SkipListAT SkipList abstract type
  *  @brief Definition of the SkipList type and operators
@@ -21,6 +24,31 @@ typedef struct s_SkipList SkipList;
  */
 typedef void(*ScanOperator)(int, void*);
 
+/**
+ *	@brief Type of the operator that one may map on a SkipList by batches of consecutive values.
+ *
+ *	The operator receives an array of values in ascending order, its number of values and the user supplied environment.
+ */
+typedef void(*BatchOperator)(const int*, size_t, void*);
+
+/**
+ *	@brief Policy used to allocate the towers of a SkipList.
+ *
+ *	MALLOC_ALLOCATOR allocates and frees each tower with malloc/free.
+ *	ARENA_ALLOCATOR carves towers from per-height slabs owned by the list, recycles removed towers
+ *	through a freelist and releases the whole list slab by slab.
+ */
+typedef enum sl_allocator{MALLOC_ALLOCATOR, ARENA_ALLOCATOR} SkipListAllocator;
+
+/**
+ *	@brief Highest number of levels of a SkipList.
+ *
+ *	Capacity of the levels of a SkipList created with 0 levels, whose height follows its size, and bound of the
+ *	number of levels of any SkipList : a SkipList created with more levels gets SKIPLIST_MAX_LEVEL levels.
+ *	The stack iterators hold one predecessor per level up to this bound.
+ */
+#define SKIPLIST_MAX_LEVEL 32
+
 /** 
  *  @brief Constructor of an empty SkipList.
  *
@@ -28,11 +56,78 @@ typedef void(*ScanOperator)(int, void*);
  * @parblock
  *	skiplist_create : \f$\rightarrow\f$ SkipList.
  * @endparblock
- *	@param nblevels the number of levels in the skip list.
+ *	@param nblevels the number of levels in the skip list, 0 to let the number of levels follow the size of the list.
+ *	A value above SKIPLIST_MAX_LEVEL is lowered to SKIPLIST_MAX_LEVEL : skiplist_stats reports the levels the list got as max_level.
  *  @return a correctly initialized SkipList.
+ *  @note with nblevels set to 0, the height of the towers is drawn up to \f$1 + \lfloor\log_2(n+1)\rfloor\f$ levels, n being
+ *	the current size of the list, within SKIPLIST_MAX_LEVEL levels. In any case, searches start from the highest non-empty level.
  */
 SkipList* skiplist_create(int nblevels);
 
+/** 
+ *  @brief Constructor of an empty SkipList using the given tower allocation policy.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_create_with_allocator : int \f$\times\f$ SkipListAllocator \f$\rightarrow\f$ SkipList.
+ * @endparblock
+ *	@param nblevels the number of levels in the skip list, 0 to let the number of levels follow the size of the list,
+ *	lowered to SKIPLIST_MAX_LEVEL as for skiplist_create.
+ *	@param allocator the allocation policy of the towers.
+ *  @return a correctly initialized SkipList.
+ *  @note skiplist_create(n) is skiplist_create_with_allocator(n, MALLOC_ALLOCATOR).
+ */
+SkipList* skiplist_create_with_allocator(int nblevels, SkipListAllocator allocator);
+
+/**
+ *  @brief Select the random generator drawing the height of the towers inserted from now on.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_set_generator : SkipList \f$\times\f$ RNGGenerator \f$\rightarrow\f$ SkipList.
+ * @endparblock
+ *	@param d the skiplist to modify.
+ *	@param generator the generator to use, restarted at the seed of the list.
+ *  @return the modified skiplist.
+ *  @note a SkipList draws with RNG_LCG by default, which the reference outputs rely on. RNG_CTZ draws a height
+ *	in a single step and follows the same probability law.
+ */
+SkipList* skiplist_set_generator(SkipList* d, RNGGenerator generator);
+
+/** 
+ *  @brief Constructor of a SkipList holding the given values.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_build_from_array : int* \f$\times\f$ size_t \f$\times\f$ int \f$\rightarrow\f$ SkipList.
+ * @endparblock
+ *	@param values the values to store, in any order and possibly duplicated.
+ *	@param n the number of values.
+ *	@param nblevels the number of levels in the skip list, 0 to let the number of levels follow the size of the list,
+ *	lowered to SKIPLIST_MAX_LEVEL as for skiplist_create.
+ *  @return a SkipList containing each value once, with random tower heights.
+ *  @note The values are sorted and deduplicated only when they are not already strictly increasing,
+ *  then all the towers are linked in one left to right pass.
+ */
+SkipList* skiplist_build_from_array(const int* values, size_t n, int nblevels);
+
+/** 
+ *  @brief Constructor of a perfectly balanced SkipList holding the given values.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_build_balanced_from_array : int* \f$\times\f$ size_t \f$\times\f$ int \f$\rightarrow\f$ SkipList.
+ * @endparblock
+ *	@param values the values to store, in any order and possibly duplicated.
+ *	@param n the number of values.
+ *	@param nblevels the number of levels in the skip list, 0 to let the number of levels follow the size of the list,
+ *	lowered to SKIPLIST_MAX_LEVEL as for skiplist_create.
+ *  @return a SkipList containing each value once, where the \f$i^{th}\f$ tower holds one level more than
+ *  the number of times 2 divides i+1, up to nblevels.
+ *  @note Same construction as skiplist_build_from_array, with deterministic tower heights.
+ */
+SkipList* skiplist_build_balanced_from_array(const int* values, size_t n, int nblevels);
+
 /**
  *  @brief Destructor of a SkipList.
  *
@@ -41,6 +136,8 @@ SkipList* skiplist_create(int nblevels);
  *	skiplist_delete : SkipList\f$\rightarrow \f$ void.
  * @endparblock
  *	@param d the skiplist to delete.
+ *  @note a list created with ARENA_ALLOCATOR is released in O(number of slabs).
+ *	@note a list with live snapshots is freed when its last snapshot is released : *d is set to NULL meanwhile.
  *
  */
 void skiplist_delete(SkipList** d);
@@ -79,10 +176,28 @@ unsigned int skiplist_size(const SkipList* d);
  * @par Axioms
  * @parblock
  * (skiplist_at(d, i) = x) \f$\wedge\f$ ( (\f$\nu\f$ y : ( (skiplist_search(d, y) = true) \f$\wedge\f$  (y \f$\le\f$ x) )) = i ) 
- * @endparblock
+ * @endparblock * @note runs in O(log n) using the number of elements covered by each link.
  */
 int skiplist_at(const SkipList* d, unsigned int i);
 
+/**
+ *  @brief Position of a value in the SkipList.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_rank : SkipList \f$\times\f$ int \f$\rightarrow\f$ int
+ * @endparblock
+ *	@param d the SkipList to access
+ *	@param value the value to locate
+ *  @return the index i such that skiplist_at(d, i) = value, or -1 if the value is not in the SkipList.
+ * @par Axioms
+ * @parblock
+ * (skiplist_search(d, x) = true) \f$\rightarrow\f$ skiplist_at(d, skiplist_rank(d, x)) = x \n
+ * (skiplist_search(d, x) = false) \f$\rightarrow\f$ skiplist_rank(d, x) = -1
+ * @endparblock
+ */
+int skiplist_rank(const SkipList* d, int value);
+
 
 /**
  *	@brief Insert the value v in the skip list d.
@@ -98,6 +213,21 @@ int skiplist_at(const SkipList* d, unsigned int i);
  */
 SkipList* skiplist_insert(SkipList* d, int value);
 
+/**
+ *	@brief Insert the value v in the skip list d and tell if it was new.
+ 
+ *	@param d the SkipList to insert into
+ *	@param value the value to insert
+ *	@param inserted set to true if the value was not in the list, false otherwise. May be NULL.
+ *  @return the eventually modified skiplist.
+ *	@note the list is searched before allocating : inserting a value already in the list leaves it unchanged
+ *	and allocates nothing. skiplist_insert(d, v) is skiplist_insert_ex(d, v, NULL).
+ *	@note a value greater than all the values of the list is appended without search : the last tower of each
+ *	level is kept by the sentinel, so ingesting ascending keys compares no value : only the widths of the links
+ *	above the new tower are updated.
+ */
+SkipList* skiplist_insert_ex(SkipList* d, int value, bool* inserted);
+
 
 /**
  *	@brief Remove the value v from the skip list d.
@@ -113,6 +243,21 @@ SkipList* skiplist_insert(SkipList* d, int value);
  */
 SkipList* skiplist_remove(SkipList* d, int value);
 
+/**
+ *	@brief Remove all the values in [lo, hi) from the skip list d.
+ 
+ *	@param d the SkipList to remove from
+ *	@param lo the lowest value to remove
+ *	@param hi the strict upper bound of the values to remove
+ *  @return the eventually modified skiplist.
+ *
+ *  @invariant The list is always ordered by ascending order
+ *	@note the parameter d is modified by side effect and is returned by the function
+ *	@note the run of removed towers is unlinked with one update per level, after two O(log n) descents to lo and hi.
+ *
+ */
+SkipList* skiplist_remove_range(SkipList* d, int lo, int hi);
+
 
 /**
  *  @brief Search for the presence of a value in a SkipList.
@@ -129,6 +274,66 @@ SkipList* skiplist_remove(SkipList* d, int value);
  */
 bool skiplist_search(const SkipList* d, int value, unsigned int *nb_operations);
 
+/**
+ *  @brief Search for the presence of several values in a SkipList.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_search_batch : SkipList \f$\times\f$ int* \f$\times\f$ size_t \f$\rightarrow\f$ bool*
+ * @endparblock
+ *	@param d the SkipList to search into
+ *	@param keys the values to search for, in any order
+ *	@param n the number of values to search for
+ *	@param found found[i] is set to skiplist_search(d, keys[i])
+ *	@param ops if not NULL, ops[i] is set to the number of tested nodes for keys[i]
+ *  @note The keys are visited in ascending order (a permutation is sorted when keys is not) and each search
+ *  starts from the predecessors of the previous key instead of the top of the list.
+ */
+void skiplist_search_batch(const SkipList* d, const int* keys, size_t n, bool* found, unsigned int* ops);
+
+/**
+ *  @brief Search for the presence of a value in a SkipList, prefetching the towers ahead of the descent.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_search_prefetch : SkipList \f$\times\f$ int \f$\rightarrow\f$ unsigned int
+ * @endparblock
+ *	@param d the SkipList to search into
+ *	@param value the value to search for
+ *	@param nb_operations The number of tested nodes during the search
+ *  @return true if the value was found, false otherwise.
+ *  @note Same result and same number of tested nodes as skiplist_search. While a tower is compared, the two towers
+ *  the next comparison may read, its successor on the level and the successor of the predecessor on the level below,
+ *  are prefetched.
+ */
+bool skiplist_search_prefetch(const SkipList* d, int value, unsigned int *nb_operations);
+
+/**
+ *	@brief Number of searches run at once by skiplist_search_interleaved.
+ */
+#ifndef SKIPLIST_SEARCH_GROUP
+#define SKIPLIST_SEARCH_GROUP 16
+#endif
+
+/**
+ *  @brief Search for the presence of several values in a SkipList, interleaving independent searches.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_search_interleaved : SkipList \f$\times\f$ int* \f$\times\f$ size_t \f$\rightarrow\f$ bool*
+ * @endparblock
+ *	@param d the SkipList to search into
+ *	@param keys the values to search for, in any order
+ *	@param n the number of values to search for
+ *	@param found found[i] is set to skiplist_search(d, keys[i])
+ *	@param ops if not NULL, ops[i] is set to the number of tested nodes for keys[i], as by skiplist_search
+ *  @note SKIPLIST_SEARCH_GROUP searches progress in turn, one tested node at a time : the tower each search
+ *  tests next is prefetched, then the other searches run while it is loaded, so that their cache misses overlap.
+ *  Unlike skiplist_search_batch, the keys are not sorted. This pays on lists far larger than the caches searched
+ *  for scattered keys : when the search paths stay in the caches, the turns cost more than the misses they hide.
+ */
+void skiplist_search_interleaved(const SkipList* d, const int* keys, size_t n, bool* found, unsigned int* ops);
+
 /**
  *  @brief Apply an operator on each member of the SkipList, from the begining to the end.
  *
@@ -142,6 +347,530 @@ bool skiplist_search(const SkipList* d, int value, unsigned int *nb_operations);
  */
 void skiplist_map(const SkipList* d, ScanOperator f, void *environment);
 
+/**
+ *  @brief Apply an operator on each member of the SkipList in [lo, hi), in ascending order.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_range_map : SkipList \f$\times\f$ int \f$\times\f$ int \f$\times\f$ ScanOperator \f$\rightarrow void\f$
+ * @endparblock
+ *	@param d the SkipList to access
+ *	@param lo the lowest value to visit
+ *	@param hi the strict upper bound of the values to visit
+ *	@param f the operator to apply
+ *	@param environment user supplied environment for calling the operator.
+ *	@note the scan starts after an O(log n) descent to lo.
+ */
+void skiplist_range_map(const SkipList* d, int lo, int hi, ScanOperator f, void *environment);
+
+/**
+ *	@brief Number of values handed at once to a BatchOperator.
+ */
+#define SKIPLIST_BATCH_KEYS 256
+
+/**
+ *  @brief Apply an operator on the members of the SkipList by batches of consecutive values, from the begining to the end.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_map_batch : SkipList \f$\times\f$ BatchOperator \f$\rightarrow void\f$
+ * @endparblock
+ *	@param d the SkipList to access
+ *	@param f the operator to apply, on arrays of at most SKIPLIST_BATCH_KEYS values
+ *	@param environment user supplied environment for calling the operator.
+ *	@note the values are copied from the towers to a buffer : the operator is called once per batch and may run
+ *	the kernels of keykernels.h on it.
+ */
+void skiplist_map_batch(const SkipList* d, BatchOperator f, void *environment);
+
+/**
+ *  @brief Aggregate of the members of the SkipList in [lo, hi).
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_aggregate_range : SkipList \f$\times\f$ int \f$\times\f$ int \f$\times\f$ KeyAggregate* \f$\rightarrow void\f$
+ * @endparblock
+ *	@param d the SkipList to access
+ *	@param lo the lowest value to aggregate
+ *	@param hi the strict upper bound of the values to aggregate
+ *	@param aggregate the aggregate to update with the count, sum, min and max of these values
+ *	@note the values are gathered by batches after an O(log n) descent to lo, and aggregated by the vectorized kernel.
+ */
+void skiplist_aggregate_range(const SkipList* d, int lo, int hi, KeyAggregate* aggregate);
+
+/*-----------------------*/
+/* Set algebra           */
+/*-----------------------*/
+
+/**
+ *  @brief Union of two SkipLists.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_union : SkipList \f$\times\f$ SkipList \f$\rightarrow\f$ SkipList
+ * @endparblock
+ *	@param a the first SkipList
+ *	@param b the second SkipList
+ *  @return a new SkipList holding the values of a or b, with the number of levels, the allocator and the random
+ *  generator of a.
+ *	@note the level 0 chains of a and b are merged in one pass, linking each tower of the result after the previous
+ *	one, as high as for an insert at the end of the list : O(n + m) instead of O(m log(n + m)) for m inserts.
+ */
+SkipList* skiplist_union(const SkipList* a, const SkipList* b);
+
+/**
+ *  @brief Intersection of two SkipLists.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_intersect : SkipList \f$\times\f$ SkipList \f$\rightarrow\f$ SkipList
+ * @endparblock
+ *	@param a the first SkipList
+ *	@param b the second SkipList
+ *  @return a new SkipList holding the values of a and b, with the number of levels, the allocator and the random
+ *  generator of a.
+ *	@note same merge as skiplist_union, where a run of either list lower than the current value of the other is
+ *	skipped by galloping along the upper levels : O(log k) for a run of k values.
+ */
+SkipList* skiplist_intersect(const SkipList* a, const SkipList* b);
+
+/**
+ *  @brief Difference of two SkipLists.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_difference : SkipList \f$\times\f$ SkipList \f$\rightarrow\f$ SkipList
+ * @endparblock
+ *	@param a the first SkipList
+ *	@param b the second SkipList
+ *  @return a new SkipList holding the values of a that are not in b, with the number of levels, the allocator and
+ *  the random generator of a.
+ *	@note same merge as skiplist_union, where a run of b lower than the current value of a is skipped by galloping.
+ */
+SkipList* skiplist_difference(const SkipList* a, const SkipList* b);
+
+/**
+ *  @brief Union of two SkipLists, in the first one.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_union_with : SkipList \f$\times\f$ SkipList \f$\rightarrow\f$ SkipList
+ * @endparblock
+ *	@param a the SkipList to modify
+ *	@param b the SkipList whose values move to a, left empty
+ *  @return a, holding the values of a or b.
+ * @pre
+ *	a \f$\neq\f$ b
+ *	@note the towers of b are spliced into a without copy when neither list uses ARENA_ALLOCATOR, and copied into
+ *	a otherwise. The towers of both lists are relinked in one left to right pass, keeping their heights.
+ *	@note the parameters a and b are modified by side effect and a is returned by the function
+ */
+SkipList* skiplist_union_with(SkipList* a, SkipList* b);
+
+/**
+ *  @brief Intersection of two SkipLists, in the first one.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_intersect_with : SkipList \f$\times\f$ SkipList \f$\rightarrow\f$ SkipList
+ * @endparblock
+ *	@param a the SkipList to modify
+ *	@param b the SkipList to intersect with
+ *  @return a, holding the values of a that are in b.
+ * @pre
+ *	a \f$\neq\f$ b
+ *	@note the towers of a not in b are freed and the others relinked in one left to right pass, the runs of b
+ *	between two values of a being skipped by galloping.
+ *	@note the parameter a is modified by side effect and is returned by the function
+ */
+SkipList* skiplist_intersect_with(SkipList* a, const SkipList* b);
+
+/**
+ *  @brief Difference of two SkipLists, in the first one.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_difference_with : SkipList \f$\times\f$ SkipList \f$\rightarrow\f$ SkipList
+ * @endparblock
+ *	@param a the SkipList to modify
+ *	@param b the SkipList whose values are removed from a
+ *  @return a, holding the values of a that are not in b.
+ * @pre
+ *	a \f$\neq\f$ b
+ *	@note same pass as skiplist_intersect_with, freeing the towers of a in b.
+ *	@note the parameter a is modified by side effect and is returned by the function
+ */
+SkipList* skiplist_difference_with(SkipList* a, const SkipList* b);
+
+/**
+ *  @brief Split a SkipList at a key.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_split : SkipList \f$\times\f$ int \f$\times\f$ SkipList** \f$\times\f$ SkipList** \f$\rightarrow\f$ void
+ * @endparblock
+ *	@param d the SkipList to split
+ *	@param key the lowest value of the right part
+ *	@param left set to d, holding the values lower than key
+ *	@param right set to a new SkipList, holding the values greater than or equal to key, with the number of levels,
+ *	the allocator and the random generator of d
+ *	@note the links of each level are cut after the predecessor of key and the towers after it are bound to the
+ *	sentinel of the new list : O(log n) to find the cut and O(levels) to cut, no tower is moved.
+ *	With ARENA_ALLOCATOR, the towers of the right part are then copied to its own arena, in O(size of the right part).
+ */
+void skiplist_split(SkipList* d, int key, SkipList** left, SkipList** right);
+
+/**
+ *  @brief Concatenation of two SkipLists.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_concat : SkipList \f$\times\f$ SkipList \f$\rightarrow\f$ SkipList
+ * @endparblock
+ *	@param a the SkipList to extend
+ *	@param b the SkipList whose values move to the end of a, left empty
+ *  @return a, holding the values of a then those of b.
+ * @pre
+ *	a \f$\neq\f$ b, and every value of a is lower than every value of b
+ *	@note the last tower of a on each level is bound to the first tower of b on this level, in O(levels) : no tower
+ *	is moved. When either list uses ARENA_ALLOCATOR, or b is higher than a allows, the towers of b are copied to the
+ *	end of a instead, in O(size of b).
+ *	@note the parameters a and b are modified by side effect and a is returned by the function
+ */
+SkipList* skiplist_concat(SkipList* a, SkipList* b);
+
+/*-----------------------*/
+/* Snapshots             */
+/*-----------------------*/
+
+/**
+ *	@brief Handle of a read-only view of a SkipList at the time it was taken.
+ *
+ *	The definition is public so that a snapshot is returned by value. Its fields are private : use the operators only.
+ *	A snapshot keeps the values of its list at the time it was taken while the writer of the list goes on modifying
+ *	it. Each insert or remove records its value in every live snapshot of the list, and the towers removed from the
+ *	list are kept until the last live snapshot is released.
+ *
+ *	The snapshots of a list may be read from other threads than its writer, while it writes : the writer holds a
+ *	lock of the list for writing during each modification while snapshots of the list are live, and each operator
+ *	on a snapshot holds it for reading. A long scan only holds it during each step of its iterator.
+ *	The list itself is still read and written by its writer only.
+ *
+ *	Each operator on a snapshot returns false when the snapshot is not live : released, or a copy of a released
+ *	handle. A handle may not be used once its list is freed.
+ */
+typedef struct s_SkipListSnapshot{
+	SkipList* list; /**< the list of the snapshot, NULL once released */
+	unsigned long long int version; /**< the number of the snapshot among those of its list */
+} SkipListSnapshot;
+
+/**
+ *  @brief Take a snapshot of a SkipList.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_snapshot : SkipList \f$\rightarrow\f$ SkipListSnapshot
+ * @endparblock
+ *	@param d the SkipList to take a snapshot of
+ *  @return a live snapshot of d, to release with skiplist_snapshot_release.
+ *	@note a snapshot records the changes of d since it was taken, in a SkipList of the values added to d and one of
+ *	the values removed from it, rather than copying the towers on the path of each change or stamping each tower with
+ *	versions. Taking a snapshot runs in O(1) and d keeps its layout, at the cost of, with S live snapshots and k values
+ *	changed since each one :
+ *	- an insert or remove in d costs one more O(log k) update per live snapshot, O(S log k) ;
+ *	- skiplist_snapshot_search runs in O(log n + log k), and skiplist_snapshot_at in O(32 (log n + log k)) ;
+ *	- skiplist_split, skiplist_concat and the in-place set operations move the values of d one by one, in
+ *	O(m log n) for m moved values, so that its snapshots record them.
+ *	Once the last snapshot of d is released, d costs no more than a list that never had one.
+ *	@note taking a snapshot modifies d : it is called by the writer of d.
+ */
+SkipListSnapshot skiplist_snapshot(SkipList* d);
+
+/**
+ *  @brief Release a snapshot of a SkipList.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_snapshot_release : SkipListSnapshot* \f$\rightarrow\f$ bool
+ * @endparblock
+ *	@param s the snapshot to release, no longer live on return
+ *  @return false if s was not live.
+ *	@note releasing the last live snapshot of a list frees the towers removed from the list meanwhile and, if the
+ *	list was deleted by skiplist_delete while the snapshot was live, the list itself.
+ */
+bool skiplist_snapshot_release(SkipListSnapshot* s);
+
+/**
+ *  @brief Number of values in a snapshot.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_snapshot_size : SkipListSnapshot \f$\times\f$ unsigned int* \f$\rightarrow\f$ bool
+ * @endparblock
+ *	@param s the snapshot
+ *	@param size set to the size of the list when the snapshot was taken
+ *  @return false if s is not live, leaving size unchanged.
+ */
+bool skiplist_snapshot_size(const SkipListSnapshot* s, unsigned int* size);
+
+/**
+ *  @brief Search for the presence of a value in a snapshot.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_snapshot_search : SkipListSnapshot \f$\times\f$ int \f$\times\f$ bool* \f$\rightarrow\f$ bool
+ * @endparblock
+ *	@param s the snapshot to search into
+ *	@param value the value to search for
+ *	@param found set to true if the value was in the list when the snapshot was taken, false otherwise
+ *	@param nb_operations The number of tested nodes during the search, in the list and in the recorded changes
+ *  @return false if s is not live, leaving found unchanged.
+ */
+bool skiplist_snapshot_search(const SkipListSnapshot* s, int value, bool* found, unsigned int *nb_operations);
+
+/**
+ *  @brief Access to the ith value of a snapshot.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_snapshot_at : SkipListSnapshot \f$\times\f$ unsigned int \f$\times\f$ int* \f$\rightarrow\f$ bool
+ * @endparblock
+ *	@param s the snapshot
+ *	@param i the index of the value, from 0
+ *	@param value set to the ith value of the list when the snapshot was taken
+ *  @return false if s is not live or i is not lower than its size, leaving value unchanged.
+ *	@note the value is found by a binary search over the values of int, counting the values of the snapshot
+ *	not greater than the middle one from the positions in the list and in the recorded changes :
+ *	O(32 (log n + log k)) instead of O(log n) for skiplist_at, k being the number of values changed since the snapshot.
+ */
+bool skiplist_snapshot_at(const SkipListSnapshot* s, unsigned int i, int* value);
+
+/**
+ *  @brief Apply a function on each value of a snapshot, in ascending order.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_snapshot_map : SkipListSnapshot \f$\times\f$ ScanOperator \f$\times\f$ void* \f$\rightarrow\f$ bool
+ * @endparblock
+ *	@param s the snapshot to scan
+ *	@param f the function to apply, called without holding the lock of the list : it may modify the list
+ *	@param environment the user supplied environment passed to f
+ *  @return false if s is not live, or is released by another thread during the scan.
+ */
+bool skiplist_snapshot_map(const SkipListSnapshot* s, ScanOperator f, void *environment);
+
+/**
+ *	@brief Iterator on the values of a snapshot, in ascending order.
+ *
+ *	The iterator walks the towers of the list, skipping those inserted since the snapshot, and merges in the values
+ *	removed since the snapshot. It stays valid while the list is modified, until the snapshot is released.
+ */
+typedef struct s_SkipListSnapshotIterator{
+	SkipListSnapshot snapshot; /**< the snapshot to iterate on */
+	struct s_Node* node; /**< the next tower of the list not yet passed, the sentinel of the list at the end */
+	int value; /**< the current value */
+	bool end; /**< true when all the values were iterated */
+} SkipListSnapshotIterator;
+
+/**
+ *  @brief Put an iterator on the first value of a snapshot.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_snapshot_iterator_init : SkipListSnapshotIterator* \f$\times\f$ SkipListSnapshot \f$\rightarrow\f$ bool
+ * @endparblock
+ *	@param it the iterator to initialize
+ *	@param s the snapshot to iterate on
+ *  @return false, leaving the iterator at the end, if s is not live.
+ */
+bool skiplist_snapshot_iterator_init(SkipListSnapshotIterator* it, const SkipListSnapshot* s);
+
+/**
+ *  @brief End of a snapshot iterator.
+ *
+ *	@param it the iterator
+ *  @return true when the iterator went past the last value of its snapshot, or its snapshot is no longer live.
+ */
+bool skiplist_snapshot_iterator_end(const SkipListSnapshotIterator* it);
+
+/**
+ *  @brief Move a snapshot iterator to the next value.
+ *
+ *	@param it the iterator
+ *  @return false, leaving the iterator at the end, if its snapshot was released meanwhile.
+ *	@note runs in O(1) amortized while the list is not modified, plus a search in the recorded changes otherwise.
+ */
+bool skiplist_snapshot_iterator_next(SkipListSnapshotIterator* it);
+
+/**
+ *  @brief Value of a snapshot iterator.
+ *
+ *	@param it the iterator
+ *  @return the current value.
+ * @pre
+ *	!skiplist_snapshot_iterator_end(it)
+ */
+int skiplist_snapshot_iterator_value(const SkipListSnapshotIterator* it);
+
+/*-----------------------*/
+/* Statistics            */
+/*-----------------------*/
+
+/**
+ *	@brief Shape of a SkipList and, when compiled with SKIPLIST_STATS, counters of the operations it went through.
+ *
+ *	The shape is measured by a scan of the list. The counters are updated on the hot paths only when the library
+ *	is compiled with SKIPLIST_STATS defined (make STATS=yes) : otherwise they are not compiled at all and stay null.
+ */
+typedef struct s_SkipListStats{
+	unsigned int size; /**< number of values in the list */
+	int max_level; /**< number of levels the towers may reach */
+	int level; /**< number of levels holding at least one tower */
+	unsigned int nodes_per_level[SKIPLIST_MAX_LEVEL]; /**< number of towers reaching each level */
+	unsigned int height_histogram[SKIPLIST_MAX_LEVEL]; /**< number of towers of i+1 levels, higher towers counted in the last entry */
+	double average_search_path; /**< average number of tested nodes to search a value of the list */
+	unsigned int max_search_path; /**< maximum number of tested nodes to search a value of the list */
+	size_t bytes_allocated; /**< bytes allocated for the list, its towers and, with ARENA_ALLOCATOR, its slabs */
+	bool counters_enabled; /**< true when the following counters are maintained */
+	unsigned long long int nb_inserts; /**< number of values inserted */
+	unsigned long long int nb_removes; /**< number of values removed */
+	unsigned long long int nb_duplicates; /**< number of inserts of a value already in the list */
+	unsigned long long int nb_searches; /**< number of values searched by skiplist_search and skiplist_search_batch */
+	unsigned long long int nb_search_operations; /**< total number of tested nodes of these searches */
+	unsigned int max_search_operations; /**< maximum number of tested nodes of these searches */
+} SkipListStats;
+
+/**
+ *  @brief Statistics of a SkipList.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_stats : SkipList \f$\times\f$ SkipListStats* \f$\rightarrow\f$ void
+ * @endparblock
+ *	@param d the SkipList to measure
+ *	@param stats the statistics to fill
+ *	@note runs in O(n \f$\times\f$ levels) : the search path of each value is deduced from its predecessors on each level,
+ *	without searching it. A list whose average search path goes far beyond \f$2\log_2 n\f$ has too few levels for its size.
+ */
+void skiplist_stats(const SkipList* d, SkipListStats* stats);
+
+
+/*-----------------------*/
+/* Persistence           */
+/*-----------------------*/
+
+/**
+ *  @brief Save a SkipList to a file.
+ *
+ *	The image holds the values in ascending order and the height of their towers, with a header giving the number
+ *	of levels, the random generator and the allocator of the list. The values and the header are stored in little
+ *	endian order whatever the host.
+ * @par Profile
+ * @parblock
+ *	skiplist_save : SkipList \f$\times\f$ char* \f$\rightarrow\f$ bool
+ * @endparblock
+ *	@param d the SkipList to save
+ *	@param path the name of the file to write
+ *  @return false if the file could not be written.
+ */
+bool skiplist_save(const SkipList* d, const char* path);
+
+/**
+ *  @brief Constructor of a SkipList from a file written by skiplist_save.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_load : char* \f$\rightarrow\f$ SkipList.
+ * @endparblock
+ *	@param path the name of the file to read
+ *  @return the saved SkipList, with the same towers, or NULL if the file can not be read or is not a valid image.
+ *	@note runs in O(n) : the towers are linked in one pass over the values, without search nor random draw.
+ */
+SkipList* skiplist_load(const char* path);
+
+/**
+ *	@brief Opaque definition of the MappedSkipList abstract data type.
+ *
+ *	A read-only SkipList served from an image file mapped in memory. The values are searched in place by
+ *	binary search, the tower heights of the image being left unused : opening an image allocates nothing per value
+ *	and the pages of the file are shared by all the processes mapping it.
+ */
+typedef struct s_MappedSkipList MappedSkipList;
+
+/**
+ *  @brief Open an image written by skiplist_save as a read-only list.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplist_open_mapped : char* \f$\rightarrow\f$ MappedSkipList.
+ * @endparblock
+ *	@param path the name of the file to map
+ *  @return the mapped list, or NULL if the file can not be read or its header is not valid.
+ *	@note runs in O(1) on a little endian host : only the header is checked, the values are trusted to ascend
+ *	as skiplist_save wrote them. The file must not be modified while it is mapped.
+ */
+MappedSkipList* skiplist_open_mapped(const char* path);
+
+/**
+ *  @brief Destructor of a MappedSkipList, unmapping its file.
+ *	@param d the list to close
+ */
+void mapped_skiplist_close(MappedSkipList** d);
+
+/**
+ *  @brief Access to the size of the MappedSkipList.
+ *	@param d the list to access
+ *  @return the number of values in the list.
+ */
+unsigned int mapped_skiplist_size(const MappedSkipList* d);
+
+/**
+ *  @brief Access to the \f$i^{th}\f$ value of the MappedSkipList, in O(1).
+ *
+ *	Iterating i from 0 to mapped_skiplist_size(d) - 1 visits the values in ascending order.
+ *	@param d the list to access
+ *	@param i the index of the required value
+ *  @return the ith value of the list.
+ * @pre
+ *	0 \f$\le\f$  i \f$<\f$  mapped_skiplist_size(d)
+ */
+int mapped_skiplist_at(const MappedSkipList* d, unsigned int i);
+
+/**
+ *  @brief Position of a value in the MappedSkipList.
+ *	@param d the list to access
+ *	@param value the value to locate
+ *  @return the index i such that mapped_skiplist_at(d, i) = value, or -1 if the value is not in the list.
+ */
+int mapped_skiplist_rank(const MappedSkipList* d, int value);
+
+/**
+ *  @brief Search for the presence of a value in a MappedSkipList.
+ *	@param d the list to search into
+ *	@param value the value to search for
+ *	@param nb_operations the number of values compared to value during the search
+ *  @return true if the value was found, false otherwise.
+ */
+bool mapped_skiplist_search(const MappedSkipList* d, int value, unsigned int *nb_operations);
+
+/**
+ *  @brief Apply an operator on each value of the MappedSkipList, in ascending order.
+ *	@param d the list to access
+ *	@param f the operator to apply
+ *	@param environment user supplied environment for calling the operator.
+ */
+void mapped_skiplist_map(const MappedSkipList* d, ScanOperator f, void *environment);
+
+/**
+ *  @brief Aggregate of the values of the MappedSkipList in [lo, hi).
+ *	@param d the list to access
+ *	@param lo the lowest value to aggregate
+ *	@param hi the strict upper bound of the values to aggregate
+ *	@param aggregate the aggregate to update with the count, sum, min and max of these values
+ *	@note the values are aggregated in place by the vectorized kernel.
+ */
+void mapped_skiplist_aggregate_range(const MappedSkipList* d, int lo, int hi, KeyAggregate* aggregate);
+
 
 /*-----------------------*/
 /* Iterator             */
@@ -154,15 +883,42 @@ void skiplist_map(const SkipList* d, ScanOperator f, void *environment);
 
 typedef enum slit_direction{BACKWARD_ITERATOR, FORWARD_ITERATOR} IteratorDirection;
 /**
- *	@brief Opaque definition of the SkipListIterator abstract data type.
+ *	@brief Definition of the SkipListIterator data type.
+ *
+ *	The definition is public so that an iterator may be declared on the stack and set by skiplist_iterator_init,
+ *	without allocation. Its fields are private : use the operators only.
+ *	An iterator is invalidated by any insert or remove in its collection, but for skiplist_iterator_erase and
+ *	skiplist_insert_hint on itself.
  */
-typedef struct s_SkipListIterator SkipListIterator;
+typedef struct s_SkipListIterator{
+	SkipList* collection; /**< the list to iterate */
+	struct s_Node* current; /**< the tower at the position of the iterator, the sentinel of the list at the end */
+	IteratorDirection direction; /**< the way the iterator goes */
+	struct s_Node* predecessors[SKIPLIST_MAX_LEVEL]; /**< for a forward iterator, the last tower before current on each level */
+} SkipListIterator;
+
+/**
+ *	@brief Initialization of an iterator, at the beginning of its collection.
+ *
+ *	@code{.c}
+ *	SkipListIterator it;
+ *	for (skiplist_iterator_init(&it, d, FORWARD_ITERATOR); !skiplist_iterator_end(&it); skiplist_iterator_next(&it)) {
+ *		...
+ *	}
+ *	@endcode
+ * @param it the iterator to initialize
+ * @param d the SkipList to iterate
+ * @param w the way the iterator will go (FORWARD_ITERATOR or BACKWARD_ITERATOR)
+ * @return the initialized iterator
+ */
+SkipListIterator* skiplist_iterator_init(SkipListIterator* it, SkipList* d, IteratorDirection w);
 
 /**
  *	@brief Constructor of an iterator.
  * @param d the SkipList to iterate
  * @param w the way the iterator will go (FORWARD_ITERATOR or BACKWARD_ITERATOR)
  * @return the correcly initialized iterator
+ * @note the iterator is allocated : skiplist_iterator_init sets an iterator of the caller instead.
  */
 SkipListIterator* skiplist_iterator_create(SkipList* d, IteratorDirection w);
 
@@ -195,6 +951,18 @@ bool skiplist_iterator_end(SkipListIterator* it);
  */
 SkipListIterator* skiplist_iterator_next(SkipListIterator* it);
 
+/**
+ *	@brief Put the iterator on a value of its collection.
+ *
+ *	A forward iterator is put on the first value greater than or equal to value,
+ *	a backward iterator on the last value lower than or equal to value.
+ *  @param it the iterator to modify
+ *  @param value the value to seek
+ *	@return the modified iterator, at the end of its collection if there is no such value
+ *	@note the parameter it is modified by side effect and is returned by the function
+ */
+SkipListIterator* skiplist_iterator_seek(SkipListIterator* it, int value);
+
 /**
  *	@brief Acces to the value of the iterator.
  *  @param it the iterator to delete
@@ -202,6 +970,38 @@ SkipListIterator* skiplist_iterator_next(SkipListIterator* it);
  */
 int skiplist_iterator_value(SkipListIterator* it);
 
+/**
+ *	@brief Remove the value of the iterator from its collection.
+ *
+ *	The tower of the value is unlinked from its neighbours, found through its own links : the list is not searched.
+ *  @param it the iterator to modify
+ *	@return the modified iterator, on the value following the removed one according to its direction
+ * @pre
+ *	!skiplist_iterator_end(it)
+ *	@note a forward iterator records the towers preceding its position while it moves, and erases in
+ *	O(height of the tower). A backward iterator reaches the links above the tower, whose width shrinks, by walking
+ *	back along the predecessors of the tower, in O(levels) without comparing any value.
+ */
+SkipListIterator* skiplist_iterator_erase(SkipListIterator* it);
+
+/**
+ *	@brief Insert the value v in the skip list d, searching its place from the position of an iterator.
+ *
+ *	When value follows the position of the iterator, the search starts from the towers preceding it, recorded by a
+ *	forward iterator or found by walking back from the tower of a backward iterator, and climbs only while the
+ *	successors are lower than value : it costs O(log k) comparisons for a value k positions away, instead of
+ *	O(log n). The positions of the predecessors are measured back along the links, up to the height of the new tower.
+ *	A value before the position of the iterator is searched from the top.
+ *	@param d the SkipList to insert into
+ *	@param hint an iterator on d, near the place of value
+ *	@param value the value to insert
+ *	@return the eventually modified skiplist.
+ *	@note the iterator is put on value, inserted or already in the list, and stays valid : inserting a run of
+ *	close values through the same iterator searches each one from the previous one.
+ *	A value greater than all the values of the list is appended without search, as by skiplist_insert.
+ */
+SkipList* skiplist_insert_hint(SkipList* d, SkipListIterator* hint, int value);
+
 
 /** @} */
 
@@ -210,6 +1010,12 @@ bool search_iterate_on_skiplist ( SkipList * d, IteratorDirection direction, int
 /** @} */
 void iterate_on_skiplist ( SkipList * d, IteratorDirection direction, ScanOperator f, void* environment);
 
+/**
+ *  @brief Print the statistics of a SkipList, then its values level by level, from the highest level.
+ *
+ *	@param d the SkipList to print
+ *	@note the values are printed for lists of at most 100 values, the statistics for any list.
+ */
 void printbylevel(SkipList* d);
 
 #endif
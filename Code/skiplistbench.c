@@ -0,0 +1,372 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "skiplist.h"
+
+/**
+ *	@defgroup SkipListBench Benchmark program for SkipList Implantation
+ *  @brief Time the operators of the SkipList type on generated keys
+ *  @{
+ */
+
+/** Print a usage message for this program.
+
+ @code{.unparsed}
+ $skiplistbench [-m min_size] [-n max_size] [-o operations]
+ 	Benchmark insert, search hit and miss (one by one, with prefetching and by interleaved groups), remove, iterate,
+ 	skiplist_at and build on lists of min_size (default 1000) to max_size (default 1000000) values, by powers of 10,
+ 	each with uniform, sequential and Zipf distributed keys.
+ 	Each timed workload runs the given number of operations (default 1000000), at most the size of the list for insert,
+ 	remove and build.
+ 	Print one CSV line per workload : workload,distribution,size,operations,ns_per_op,p50_ns,p99_ns,peak_rss_kb
+ 	p50 and p99 are measured on a sample of the operations and left empty for the workloads timed as a whole.
+ @endcode
+ */
+void usage(const char *command) {
+	printf("usage : %s [-m min_size] [-n max_size] [-o operations]\n", command);
+	printf("\tBenchmark insert, search hit and miss (one by one, with prefetching and by interleaved groups), remove, iterate,\n");
+	printf("\tskiplist_at and build on lists of min_size (default 1000) to max_size (default 1000000) values, by powers of 10,\n");
+	printf("\teach with uniform, sequential and Zipf distributed keys.\n");
+	printf("\tEach timed workload runs the given number of operations (default 1000000), at most the size of the list for insert,\n");
+	printf("\tremove and build.\n");
+	printf("\tPrint one CSV line per workload : workload,distribution,size,operations,ns_per_op,p50_ns,p99_ns,peak_rss_kb\n");
+	printf("\tp50 and p99 are measured on a sample of the operations and left empty for the workloads timed as a whole.\n");
+}
+
+/*----------------------------------------------------------------------------------------------*/
+
+/** Keys.
+ A list of size n holds the keys 2r for the ranks r in [0, n) : the odd keys are never found.
+ The ranks are drawn uniformly, in increasing order or following a Zipf law of exponent ZIPF_EXPONENT.
+ Uniform and Zipf ranks are scattered over the list by a permutation, so that the most frequent Zipf ranks are not
+ the first values of the list.
+ */
+#define ZIPF_EXPONENT 0.99
+
+typedef enum e_Distribution {UNIFORM, SEQUENTIAL, ZIPF} Distribution;
+
+const char *distribution_names[] = {"uniform", "sequential", "zipf"};
+
+typedef struct s_KeyStream {
+	Distribution distribution;
+	unsigned int size;
+	unsigned long long int count;
+	uint64_t state;
+} KeyStream;
+
+uint64_t bench_random(uint64_t *state) {
+	uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+KeyStream key_stream(Distribution distribution, unsigned int size, uint64_t seed) {
+	KeyStream s = {distribution, size, 0, seed};
+	return s;
+}
+
+/** Permutation of [0, size) : 2654435761 is prime with the powers of 10. */
+unsigned int scatter(unsigned int rank, unsigned int size) {
+	return (unsigned int)((uint64_t)rank * 2654435761u % size);
+}
+
+/** Next rank of the stream. Zipf ranks come from the inversion of the continuous power law, a close approximation
+ of the discrete law that draws each rank in constant time and memory. */
+unsigned int next_rank(KeyStream *s) {
+	unsigned long long int i = s->count++;
+	if (s->distribution == SEQUENTIAL) {
+		return (unsigned int)(i % s->size);
+	}
+	double u = (double)(bench_random(&s->state) >> 11) / 9007199254740992.0;
+	if (s->distribution == UNIFORM) {
+		return scatter((unsigned int)(u * s->size), s->size);
+	}
+	double exponent = 1 - ZIPF_EXPONENT;
+	double rank = pow((pow(s->size + 1.0, exponent) - 1) * u + 1, 1 / exponent) - 1;
+	unsigned int r = rank < s->size ? (unsigned int)rank : s->size - 1;
+	return scatter(r, s->size);
+}
+
+/** Key of a rank, present in the list when hit is true. */
+int key_of(unsigned int rank, bool hit) {
+	return (int)(2 * rank + (hit ? 0 : 1));
+}
+
+/** The n keys of the list, in the order of the distribution. Uniform keys are all distinct, sequential keys increase
+ and Zipf keys repeat the frequent ranks. */
+int *stream_keys(Distribution distribution, unsigned int n, uint64_t seed) {
+	int *keys = malloc((n + 1)*sizeof(int));
+	if (!keys) {
+		fprintf(stderr, "Failed to allocated memory for the keys\n");
+		exit(1);
+	}
+	KeyStream s = key_stream(distribution, n, seed);
+	for (unsigned int i = 0; i < n; ++i) {
+		keys[i] = key_of(distribution == UNIFORM ? scatter(i, n) : next_rank(&s), true);
+	}
+	return keys;
+}
+
+/*----------------------------------------------------------------------------------------------*/
+
+/** Measures.
+ A workload runs its operations in one timed loop. One operation every stride is also timed alone, up to
+ MAX_SAMPLES operations, to estimate the latency percentiles.
+ */
+#define MAX_SAMPLES 16384
+
+typedef struct s_Measure {
+	struct timespec start;
+	double samples[MAX_SAMPLES];
+	unsigned int nb_samples;
+	unsigned long long int stride;
+} Measure;
+
+double now_ns(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+void measure_start(Measure *m, unsigned long long int nb_operations) {
+	m->nb_samples = 0;
+	m->stride = nb_operations / MAX_SAMPLES + 1;
+	clock_gettime(CLOCK_MONOTONIC, &m->start);
+}
+
+bool measure_sampled(const Measure *m, unsigned long long int i) {
+	return i % m->stride == 0 && m->nb_samples < MAX_SAMPLES;
+}
+
+void measure_sample(Measure *m, double start) {
+	m->samples[m->nb_samples++] = now_ns() - start;
+}
+
+int compare_doubles(const void *a, const void *b) {
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+long peak_rss_kb(void) {
+#ifndef _WIN32
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+		return usage.ru_maxrss;
+	}
+#endif
+	return 0;
+}
+
+void measure_report(Measure *m, const char *workload, Distribution distribution, unsigned int size, unsigned long long int nb_operations) {
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double elapsed = (end.tv_sec - m->start.tv_sec) * 1e9 + (end.tv_nsec - m->start.tv_nsec);
+	printf("%s,%s,%u,%llu,%.1f,", workload, distribution_names[distribution], size, nb_operations, elapsed / nb_operations);
+	if (m->nb_samples > 0) {
+		qsort(m->samples, m->nb_samples, sizeof(double), compare_doubles);
+		printf("%.0f,%.0f", m->samples[m->nb_samples / 2], m->samples[(unsigned int)(m->nb_samples * 0.99)]);
+	} else {
+		printf(",");
+	}
+	printf(",%ld\n", peak_rss_kb());
+	fflush(stdout);
+}
+
+/*----------------------------------------------------------------------------------------------*/
+
+/** Workloads.
+ Each workload but insert and build runs on a list built from the keys of its size.
+ */
+void bench_insert(Distribution distribution, unsigned int size, Measure *m) {
+	int *keys = stream_keys(distribution, size, 1);
+	SkipList* l = skiplist_create(0);
+	measure_start(m, size);
+	for (unsigned int i = 0; i < size; ++i) {
+		if (measure_sampled(m, i)) {
+			double start = now_ns();
+			l = skiplist_insert(l, keys[i]);
+			measure_sample(m, start);
+		} else {
+			l = skiplist_insert(l, keys[i]);
+		}
+	}
+	measure_report(m, "insert", distribution, size, size);
+	skiplist_delete(&l);
+	free(keys);
+}
+
+void bench_build(Distribution distribution, unsigned int size, Measure *m) {
+	int *keys = stream_keys(distribution, size, 1);
+	m->nb_samples = 0;
+	clock_gettime(CLOCK_MONOTONIC, &m->start);
+	SkipList* l = skiplist_build_from_array(keys, size, 0);
+	measure_report(m, "build", distribution, size, size);
+	skiplist_delete(&l);
+	free(keys);
+}
+
+/** Ways to search the list : one search at a time, with prefetching, or SEARCH_GROUP_KEYS keys at a time by
+ interleaved searches. */
+typedef enum e_SearchMode {PLAIN, PREFETCH, INTERLEAVED} SearchMode;
+
+const char *search_mode_names[] = {"", "_prefetch", "_interleaved"};
+
+#define SEARCH_GROUP_KEYS 1024
+
+bool search_key(SkipList* l, int key, SearchMode mode) {
+	unsigned int nb_operations = 0;
+	return mode == PREFETCH ? skiplist_search_prefetch(l, key, &nb_operations) : skiplist_search(l, key, &nb_operations);
+}
+
+void bench_search(SkipList* l, Distribution distribution, unsigned int size, unsigned long long int nb_operations, bool hit, SearchMode mode, Measure *m) {
+	KeyStream s = key_stream(distribution, size, 2);
+	unsigned long long int found = 0;
+	char workload[32];
+	snprintf(workload, sizeof(workload), "%s%s", hit ? "search_hit" : "search_miss", search_mode_names[mode]);
+	if (mode == INTERLEAVED) {
+		// timed as a whole, with the drawing of the keys as the other modes
+		int keys[SEARCH_GROUP_KEYS];
+		bool results[SEARCH_GROUP_KEYS];
+		m->nb_samples = 0;
+		clock_gettime(CLOCK_MONOTONIC, &m->start);
+		for (unsigned long long int i = 0; i < nb_operations; i += SEARCH_GROUP_KEYS) {
+			size_t n = nb_operations - i < SEARCH_GROUP_KEYS ? (size_t)(nb_operations - i) : SEARCH_GROUP_KEYS;
+			for (size_t k = 0; k < n; ++k) {
+				keys[k] = key_of(next_rank(&s), hit);
+			}
+			skiplist_search_interleaved(l, keys, n, results, NULL);
+			for (size_t k = 0; k < n; ++k) {
+				found += results[k];
+			}
+		}
+	} else {
+		measure_start(m, nb_operations);
+		for (unsigned long long int i = 0; i < nb_operations; ++i) {
+			int key = key_of(next_rank(&s), hit);
+			if (measure_sampled(m, i)) {
+				double start = now_ns();
+				found += search_key(l, key, mode);
+				measure_sample(m, start);
+			} else {
+				found += search_key(l, key, mode);
+			}
+		}
+	}
+	measure_report(m, workload, distribution, size, nb_operations);
+	if (found != (hit ? nb_operations : 0)) {
+		fprintf(stderr, "Unexpected search results : %llu found\n", found);
+	}
+}
+
+void bench_at(SkipList* l, Distribution distribution, unsigned int size, unsigned long long int nb_operations, Measure *m) {
+	KeyStream s = key_stream(distribution, size, 3);
+	long long int checksum = 0;
+	measure_start(m, nb_operations);
+	for (unsigned long long int i = 0; i < nb_operations; ++i) {
+		unsigned int index = next_rank(&s);
+		if (measure_sampled(m, i)) {
+			double start = now_ns();
+			checksum += skiplist_at(l, index);
+			measure_sample(m, start);
+		} else {
+			checksum += skiplist_at(l, index);
+		}
+	}
+	measure_report(m, "at", distribution, size, nb_operations);
+	if (checksum < 0) {
+		fprintf(stderr, "Unexpected values\n");
+	}
+}
+
+void bench_iterate(SkipList* l, Distribution distribution, unsigned int size, unsigned long long int nb_operations, Measure *m) {
+	unsigned long long int nb_passes = nb_operations / size + 1;
+	long long int checksum = 0;
+	m->nb_samples = 0;
+	clock_gettime(CLOCK_MONOTONIC, &m->start);
+	for (unsigned long long int pass = 0; pass < nb_passes; ++pass) {
+		SkipListIterator e;
+		for (skiplist_iterator_init(&e, l, FORWARD_ITERATOR); !skiplist_iterator_end(&e); skiplist_iterator_next(&e)) {
+			checksum += skiplist_iterator_value(&e);
+		}
+	}
+	measure_report(m, "iterate", distribution, size, nb_passes * size);
+	if (checksum < 0) {
+		fprintf(stderr, "Unexpected values\n");
+	}
+}
+
+void bench_remove(SkipList* l, Distribution distribution, unsigned int size, Measure *m) {
+	KeyStream s = key_stream(distribution, size, 4);
+	unsigned int nb_operations = size;
+	measure_start(m, nb_operations);
+	for (unsigned int i = 0; i < nb_operations; ++i) {
+		int key = key_of(distribution == UNIFORM ? scatter(i, size) : next_rank(&s), true);
+		if (measure_sampled(m, i)) {
+			double start = now_ns();
+			l = skiplist_remove(l, key);
+			measure_sample(m, start);
+		} else {
+			l = skiplist_remove(l, key);
+		}
+	}
+	measure_report(m, "remove", distribution, size, nb_operations);
+}
+
+void bench_size(Distribution distribution, unsigned int size, unsigned long long int nb_operations, Measure *m) {
+	bench_insert(distribution, size, m);
+	bench_build(distribution, size, m);
+	int *keys = stream_keys(SEQUENTIAL, size, 1);
+	SkipList* l = skiplist_build_from_array(keys, size, 0);
+	free(keys);
+	for (SearchMode mode = PLAIN; mode <= INTERLEAVED; ++mode) {
+		bench_search(l, distribution, size, nb_operations, true, mode, m);
+		bench_search(l, distribution, size, nb_operations, false, mode, m);
+	}
+	bench_at(l, distribution, size, nb_operations, m);
+	bench_iterate(l, distribution, size, nb_operations, m);
+	bench_remove(l, distribution, size, m);
+	skiplist_delete(&l);
+}
+
+int main(int argc, const char *argv[]){
+	unsigned long long int min_size = 1000;
+	unsigned long long int max_size = 1000000;
+	unsigned long long int nb_operations = 1000000;
+	for (int i = 1; i < argc; ++i) {
+		if (i + 1 < argc && strcmp(argv[i], "-m") == 0) {
+			min_size = strtoull(argv[++i], NULL, 10);
+		} else if (i + 1 < argc && strcmp(argv[i], "-n") == 0) {
+			max_size = strtoull(argv[++i], NULL, 10);
+		} else if (i + 1 < argc && strcmp(argv[i], "-o") == 0) {
+			nb_operations = strtoull(argv[++i], NULL, 10);
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (min_size == 0 || max_size > 0x3FFFFFFF || nb_operations == 0) {
+		usage(argv[0]);
+		return 1;
+	}
+	Measure *m = malloc(sizeof(Measure));
+	printf("workload,distribution,size,operations,ns_per_op,p50_ns,p99_ns,peak_rss_kb\n");
+	for (unsigned long long int size = min_size; size <= max_size; size *= 10) {
+		for (Distribution distribution = UNIFORM; distribution <= ZIPF; ++distribution) {
+			bench_size(distribution, (unsigned int)size, nb_operations, m);
+		}
+	}
+	free(m);
+	return 0;
+}
+
+/** @} */
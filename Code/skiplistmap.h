@@ -0,0 +1,246 @@
+#ifndef __SKIPLISTMAP_H__
+#define __SKIPLISTMAP_H__
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "skiplist.h"
+#include "rng.h"
+
+/**
+ *	@defgroup SkipListMapAT SkipList map abstract types
+ *  @brief Ordered maps from keys to payloads, generated for given key and payload types
+ *
+ *	SKIPLIST_DEFINE(name, key_type, value_type, cmp) defines the type name and its operators name_create, name_delete,
+ *	name_size, name_put, name_get, name_erase and name_map. The payload is stored inline in the tower of its key,
+ *	and the keys are compared by cmp(a, b), a function or a macro returning a negative, null or positive integer
+ *	as a is lower than, equal to or greater than b. The comparison is expanded in each operator, without function pointer.
+ *
+ *	@code{.c}
+ *	SKIPLIST_DEFINE(intmap, int, double, SKIPLIST_COMPARE_NUMBERS)
+ *
+ *	intmap* m = intmap_create(0);
+ *	intmap_put(m, 42, 3.14);
+ *	double* payload = intmap_get(m, 42);
+ *	intmap_erase(m, 42, NULL);
+ *	intmap_delete(&m);
+ *	@endcode
+ *
+ *	SkipListMap is the instance mapping untyped keys to untyped payloads, compared by a comparator given at creation.
+ *  @{
+ */
+
+/**
+ *	@brief Comparison of two numbers of any type, usable as the comparator of SKIPLIST_DEFINE.
+ */
+#define SKIPLIST_COMPARE_NUMBERS(a, b) (((a) > (b)) - ((a) < (b)))
+
+/**
+ *	@brief Number of levels drawn by a map created with 0 levels holding size pairs : 1 + floor(log2(size+1)).
+ */
+static inline unsigned int skiplistmap_levels(unsigned int size){
+	int levels = 32 - __builtin_clz(size + 1);
+	return (unsigned int)(levels < SKIPLIST_MAX_LEVEL ? levels : SKIPLIST_MAX_LEVEL);
+}
+
+/**
+ *	@brief Define an ordered map type named name, from key_type to value_type, with the given operators.
+ *	@param name the name of the type, prefix of its operators.
+ *	@param key_type the type of the keys.
+ *	@param value_type the type of the payloads.
+ *	@param cmp the comparator of the keys, called as cmp(a, b).
+ */
+#define SKIPLIST_DEFINE(name, key_type, value_type, cmp) \
+	SKIPLIST_DEFINE_WITH_FIELDS(name, key_type, value_type, cmp(a, b), )
+
+/**
+ *	@brief Define an ordered map type named name, holding the additional fields and whose keys a and b
+ *	of a map m are compared by the given expression.
+ *
+ *	The operators are those of SKIPLIST_DEFINE. The additional fields are left uninitialized by name_create.
+ */
+#define SKIPLIST_DEFINE_WITH_FIELDS(name, key_type, value_type, compare_expression, fields) \
+typedef struct name##_node_s name##_node; \
+struct name##_node_s{ \
+	key_type key; \
+	value_type value; \
+	int node_level; \
+	name##_node* next[]; \
+}; \
+\
+typedef struct name##_s{ \
+	name##_node* head; \
+	int max_level; \
+	int level; \
+	bool adaptive; \
+	unsigned int size; \
+	RNG rng; \
+	fields \
+} name; \
+\
+static inline int name##_compare(const name* m, key_type a, key_type b){ \
+	(void)m; \
+	return (compare_expression); \
+} \
+\
+/* Constructor of an empty map, 0 levels letting the number of levels follow the size of the map. */ \
+static inline name* name##_create(int nblevels){ \
+	bool adaptive = nblevels == 0; \
+	if (adaptive){ \
+		nblevels = SKIPLIST_MAX_LEVEL; \
+	} \
+	name* m = malloc(sizeof(name) + sizeof(name##_node) + (size_t)nblevels*sizeof(name##_node*)); \
+	if (!m){ \
+		fprintf(stderr, "Memory allocation failed for " #name ",\n"); \
+		exit(1); \
+	} \
+	m->head = (name##_node*)(m+1); \
+	m->head->node_level = nblevels; \
+	for (int i = 0; i < nblevels; i++){ \
+		m->head->next[i] = NULL; \
+	} \
+	m->max_level = nblevels; \
+	m->level = 1; \
+	m->adaptive = adaptive; \
+	m->size = 0; \
+	m->rng = rng_initialize_generator(0x7FFFFFFF, adaptive ? skiplistmap_levels(0) : (unsigned int)nblevels, RNG_CTZ); \
+	return m; \
+} \
+\
+static inline void name##_delete(name** m){ \
+	name##_node* node = (*m)->head->next[0]; \
+	while (node){ \
+		name##_node* next_node = node->next[0]; \
+		free(node); \
+		node = next_node; \
+	} \
+	free(*m); \
+	*m = NULL; \
+} \
+\
+static inline unsigned int name##_size(const name* m){ \
+	return m->size; \
+} \
+\
+/* First tower whose key is greater than or equal to key, NULL if none. When update is not NULL, update[i] receives \
+   the last tower of level i whose key is lower than key. */ \
+static inline name##_node* name##_find(const name* m, key_type key, name##_node** update){ \
+	name##_node* node = m->head; \
+	for (int level = m->level-1; level >= 0; --level){ \
+		name##_node* next = node->next[level]; \
+		while (next && name##_compare(m, next->key, key) < 0){ \
+			node = next; \
+			next = node->next[level]; \
+		} \
+		if (update){ \
+			update[level] = node; \
+		} \
+	} \
+	return node->next[0]; \
+} \
+\
+/* Payload of key, NULL if key is not in the map. */ \
+static inline value_type* name##_get(const name* m, key_type key){ \
+	name##_node* node = name##_find(m, key, NULL); \
+	return node && name##_compare(m, node->key, key) == 0 ? &node->value : NULL; \
+} \
+\
+/* Associate value to key, replacing the previous payload of key if any. Returns the stored payload. */ \
+static inline value_type* name##_put(name* m, key_type key, value_type value){ \
+	name##_node* update[m->max_level]; \
+	name##_node* node = name##_find(m, key, update); \
+	if (node && name##_compare(m, node->key, key) == 0){ \
+		node->value = value; \
+		return &node->value; \
+	} \
+	int level = (int)rng_get_value(&m->rng) + 1; \
+	node = malloc(sizeof(name##_node) + (size_t)level*sizeof(name##_node*)); \
+	if (!node){ \
+		fprintf(stderr, "Failed to allocated memory for a new node\n"); \
+		exit(1); \
+	} \
+	node->key = key; \
+	node->value = value; \
+	node->node_level = level; \
+	for (int i = m->level; i < level; i++){ \
+		update[i] = m->head; \
+	} \
+	if (level > m->level){ \
+		m->level = level; \
+	} \
+	for (int i = 0; i < level; i++){ \
+		node->next[i] = update[i]->next[i]; \
+		update[i]->next[i] = node; \
+	} \
+	m->size += 1; \
+	if (m->adaptive){ \
+		rng_set_upper_bound(&m->rng, skiplistmap_levels(m->size)); \
+	} \
+	return &node->value; \
+} \
+\
+/* Remove key from the map. Returns false if key is not in the map, otherwise stores its payload into value when not NULL. */ \
+static inline bool name##_erase(name* m, key_type key, value_type* value){ \
+	name##_node* update[m->max_level]; \
+	name##_node* node = name##_find(m, key, update); \
+	if (!node || name##_compare(m, node->key, key) != 0){ \
+		return false; \
+	} \
+	for (int i = 0; i < node->node_level; i++){ \
+		update[i]->next[i] = node->next[i]; \
+	} \
+	if (value){ \
+		*value = node->value; \
+	} \
+	free(node); \
+	m->size -= 1; \
+	while (m->level > 1 && !m->head->next[m->level-1]){ \
+		m->level -= 1; \
+	} \
+	if (m->adaptive){ \
+		rng_set_upper_bound(&m->rng, skiplistmap_levels(m->size)); \
+	} \
+	return true; \
+} \
+\
+/* Apply f on each key and payload of the map, in increasing order of the keys. */ \
+static inline void name##_map(name* m, void (*f)(key_type, value_type*, void*), void *environment){ \
+	for (name##_node* node = m->head->next[0]; node; node = node->next[0]){ \
+		f(node->key, &node->value, environment); \
+	} \
+}
+
+/**
+ *	@brief Comparator of the keys of a SkipListMap.
+ */
+typedef int (*SkipListMapComparator)(const void*, const void*);
+
+SKIPLIST_DEFINE_WITH_FIELDS(skiplistmap, const void*, void*, m->compare(a, b), SkipListMapComparator compare;)
+
+/**
+ *	@brief Map from untyped keys to untyped payloads.
+ *
+ *	Its operators are those of SKIPLIST_DEFINE, prefixed by skiplistmap_, the map being created by skiplistmap_create_with_comparator.
+ */
+typedef skiplistmap SkipListMap;
+
+/**
+ *  @brief Constructor of an empty SkipListMap.
+ *
+ * @par Profile
+ * @parblock
+ *	skiplistmap_create_with_comparator : int \f$\times\f$ SkipListMapComparator \f$\rightarrow\f$ SkipListMap.
+ * @endparblock
+ *	@param nblevels the number of levels in the skip list, 0 to let the number of levels follow the size of the map.
+ *	@param compare the comparator of the keys.
+ *  @return a correctly initialized SkipListMap.
+ */
+static inline SkipListMap* skiplistmap_create_with_comparator(int nblevels, SkipListMapComparator compare){
+	SkipListMap* m = skiplistmap_create(nblevels);
+	m->compare = compare;
+	return m;
+}
+
+/** @} */
+
+#endif
@@ -1,8 +1,24 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <limits.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#endif
 
 #include "skiplist.h"
+#include "concurrentskiplist.h"
+#include "skiplistmap.h"
+#include "blockskiplist.h"
 #include "rng.h"
 
 
@@ -23,6 +39,63 @@
  	i : construct the skiplist with data read from file ../Test/test_files/construct_num.txt and search, using an iterator, elements read from file test_files/search_num.txt
  		Print statistics about the searches.
  	r : construct the skiplist with data read from file test_files/construct_num.txt, remove values read from file test_files/remove_num.txt and print the list in reverse order
+ 	E : same as r, erasing the values through an iterator while sweeping the list, then check further erases against skiplist_remove
+ 	U : construct the skiplists with data read from files test_files/construct_num.txt and test_files/remove_num.txt, print their union,
+ 		intersection and difference, then check them and the operations in place against inserts and searches value by value
+ 	C : construct the skiplist with data read from file test_files/construct_num.txt, split it at its median value, print the left part and
+ 		the right part in reverse order, then check splits and concatenations against the list
+ 	H : same as c, inserting through an iterator left on the previous value, then check ascending and hinted inserts against skiplist_insert
+ 	N : same as c, printing a snapshot of the list while its values are removed and their successors inserted, then check snapshots
+ 		against copies of the list while another thread reads them, and check that released snapshots are refused
+ 	f : construct the skiplist with data read from file test_files/construct_num.txt and search elements from file test_files/search_num.txt
+ 		one by one and by batches. Print the number of operations of each way.
+ 	P : construct the skiplist with data read from file test_files/construct_num.txt and search elements from file test_files/search_num.txt
+ 		with prefetching and by interleaved searches. Check the results and the number of operations against skiplist_search.
+ 	w : construct the skiplist with data read from file test_files/construct_num.txt, scan then remove the window between its first and third quartiles
+ 	e : same checks as a and o on a skiplist whose number of levels follows its size, built with data read from file test_files/construct_num.txt
+ 	d : check, by a chi-squared test, that the heights drawn by each random generator for the number of levels read from file test_files/construct_num.txt
+ 		follow the expected probability law
+ 	p : construct the skiplist with data read from file test_files/construct_num.txt, print it level by level with its statistics
+ 		and check them, before and after removing values read from file test_files/remove_num.txt
+ 	k : same as r with ordered maps from the values to their index in file test_files/construct_num.txt, checking the payloads
+ 	q : construct the skiplist with data read from file test_files/construct_num.txt, aggregate it and the window between
+ 		its first and third quartiles, and check the aggregation kernels
+ 	S : construct the skiplist with data read from file test_files/construct_num.txt, save it, load it back and print it,
+ 		then check the loaded list and the mapped image against it
+ 	j : same as r with a block skiplist, then check it against a skiplist through random inserts and removes
+ 	u : same as r with a concurrent skiplist, built and modified by several threads at once, then check more live concurrent
+ 		skiplists than a process has thread keys
+ 	o : construct the skiplist with data read from file test_files/construct_num.txt, search elements from file test_files/search_num.txt
+ 		and check that the mean number of operations stays within the expected O(log n) bound.
+ 	a : construct the skiplist with data read from file test_files/construct_num.txt, print its percentiles and check skiplist_at and skiplist_rank
+ 		against a scan of the list, before and after removing values read from file test_files/remove_num.txt
+ 	b : benchmark the construction of the skiplist with data read from file test_files/construct_num.txt by repeated inserts and by bulk loading
+ 	m : benchmark insert/remove churn on the values read from file test_files/remove_num.txt with the malloc and the arena allocators
+ 	A : benchmark the ingest of n ascending keys (n given as third argument, defaults to 10000000) in an array and in a skiplist,
+ 		then of nearly sorted keys and of a sorted run spread over the list by skiplist_insert and by skiplist_insert_hint
+ 	G : benchmark the union and the intersection of two skiplists of n values (n given as third argument, defaults to 1000000)
+ 		value by value, by merge and in place
+ 	K : benchmark moving the upper half of a skiplist of n values (n given as third argument, defaults to 1000000) to another one and back
+ 		by removes and inserts and by split and concatenation
+ 	W : benchmark the scan of a skiplist of n values (n given as third argument, defaults to 1000000) while half of them are moved,
+ 		in a copy of the list and in a snapshot, then in a snapshot while another thread moves them
+ 	V : benchmark the eviction of half the values of a skiplist of n values (n given as third argument, defaults to 1000000)
+ 		by a sweep calling skiplist_remove and by a sweep erasing through the iterator
+ 	h : benchmark the drawing of tower heights by each random generator, for the number of levels read from file test_files/construct_num.txt
+ 	l : benchmark searches in a skiplist whose number of levels follows its size, and in a skiplist with num levels, growing from 10 to n values
+ 		(n given as third argument, defaults to 10000000)
+ 	v : benchmark the lookups in ordered maps of n values (n given as third argument, defaults to 1000000) with int, uint64 and untyped keys,
+ 		and in a skiplist of num levels
+ 	y : benchmark searches and scans in a skiplist and a block skiplist of n values (n given as third argument, defaults to 1000000)
+ 	z : benchmark the aggregation of n values (n given as third argument, defaults to 1000000) by scan, by batches and
+ 		by the kernels of each implementation on a skiplist and on a block skiplist
+ 	L : benchmark the construction, the save, the load and the mapping of a skiplist of n values (n given as third argument,
+ 		defaults to 1000000), and the searches in the loaded list and in the mapped image
+ 	n : benchmark a stream of inserts, 90% of them duplicates, in a skiplist of num levels
+ 	x : convert the files test_files/construct_num.txt, test_files/search_num.txt and test_files/remove_num.txt to their binary form
+ 		test_files/action_num.bin, used from then on while the text files are unchanged, and compare the time to load each form
+ 	t : benchmark mixed searches and updates from 1 to n threads (n given as third argument, defaults to the number of cores)
+ 		on a concurrent skiplist and on a skiplist protected by a global mutex
  
  and num is the file number for input.
  @endcode
@@ -34,9 +107,53 @@ void usage(const char *command) {
 	printf("\ts : construct the skiplist with data read from file test_files/construct_num.txt and search elements from file test_files/search_num..txt\n\t\tPrint statistics about the searches.\n");
 	printf("\ti : construct the skiplist with data read from file test_files/construct_num.txt and search, using an iterator, elements read from file test_files/search_num.txt\n\t\tPrint statistics about the searches.\n");
 	printf("\tr : construct the skiplist with data read from file test_files/construct_num.txt, remove values read from file test_files/remove_num.txt and print the list in reverse order\n");
+	printf("\tE : same as r, erasing the values through an iterator while sweeping the list, then check further erases against skiplist_remove\n");
+	printf("\tU : construct the skiplists with data read from files test_files/construct_num.txt and test_files/remove_num.txt, print their union,\n\t\tintersection and difference, then check them and the operations in place against inserts and searches value by value\n");
+	printf("\tC : construct the skiplist with data read from file test_files/construct_num.txt, split it at its median value, print the left part and\n\t\tthe right part in reverse order, then check splits and concatenations against the list\n");
+	printf("\tH : same as c, inserting through an iterator left on the previous value, then check ascending and hinted inserts against skiplist_insert\n");
+	printf("\tN : same as c, printing a snapshot of the list while its values are removed and their successors inserted, then check snapshots\n\t\tagainst copies of the list while another thread reads them, and check that released snapshots are refused\n");
+	printf("\tf : construct the skiplist with data read from file test_files/construct_num.txt and search elements from file test_files/search_num.txt\n\t\tone by one and by batches. Print the number of operations of each way.\n");
+	printf("\tP : construct the skiplist with data read from file test_files/construct_num.txt and search elements from file test_files/search_num.txt\n\t\twith prefetching and by interleaved searches. Check the results and the number of operations against skiplist_search.\n");
+	printf("\tw : construct the skiplist with data read from file test_files/construct_num.txt, scan then remove the window between its first and third quartiles\n");
+	printf("\te : same checks as a and o on a skiplist whose number of levels follows its size, built with data read from file test_files/construct_num.txt\n");
+	printf("\td : check, by a chi-squared test, that the heights drawn by each random generator for the number of levels read from file test_files/construct_num.txt\n\t\tfollow the expected probability law\n");
+	printf("\tp : construct the skiplist with data read from file test_files/construct_num.txt, print it level by level with its statistics\n\t\tand check them, before and after removing values read from file test_files/remove_num.txt\n");
+	printf("\tk : same as r with ordered maps from the values to their index in file test_files/construct_num.txt, checking the payloads\n");
+	printf("\tq : construct the skiplist with data read from file test_files/construct_num.txt, aggregate it and the window between\n\t\tits first and third quartiles, and check the aggregation kernels\n");
+	printf("\tS : construct the skiplist with data read from file test_files/construct_num.txt, save it, load it back and print it,\n\t\tthen check the loaded list and the mapped image against it\n");
+	printf("\tj : same as r with a block skiplist, then check it against a skiplist through random inserts and removes\n");
+	printf("\tu : same as r with a concurrent skiplist, built and modified by several threads at once, then check more live concurrent\n\t\tskiplists than a process has thread keys\n");
+	printf("\to : construct the skiplist with data read from file test_files/construct_num.txt, search elements from file test_files/search_num.txt\n\t\tand check that the mean number of operations stays within the expected O(log n) bound.\n");
+	printf("\ta : construct the skiplist with data read from file test_files/construct_num.txt, print its percentiles and check skiplist_at and skiplist_rank\n\t\tagainst a scan of the list, before and after removing values read from file test_files/remove_num.txt\n");
+	printf("\tb : benchmark the construction of the skiplist with data read from file test_files/construct_num.txt by repeated inserts and by bulk loading\n");
+	printf("\tm : benchmark insert/remove churn on the values read from file test_files/remove_num.txt with the malloc and the arena allocators\n");
+	printf("\tA : benchmark the ingest of n ascending keys (n given as third argument, defaults to 10000000) in an array and in a skiplist,\n\t\tthen of nearly sorted keys and of a sorted run spread over the list by skiplist_insert and by skiplist_insert_hint\n");
+	printf("\tG : benchmark the union and the intersection of two skiplists of n values (n given as third argument, defaults to 1000000)\n\t\tvalue by value, by merge and in place\n");
+	printf("\tK : benchmark moving the upper half of a skiplist of n values (n given as third argument, defaults to 1000000) to another one and back\n\t\tby removes and inserts and by split and concatenation\n");
+	printf("\tW : benchmark the scan of a skiplist of n values (n given as third argument, defaults to 1000000) while half of them are moved,\n\t\tin a copy of the list and in a snapshot, then in a snapshot while another thread moves them\n");
+	printf("\tV : benchmark the eviction of half the values of a skiplist of n values (n given as third argument, defaults to 1000000)\n\t\tby a sweep calling skiplist_remove and by a sweep erasing through the iterator\n");
+	printf("\th : benchmark the drawing of tower heights by each random generator, for the number of levels read from file test_files/construct_num.txt\n");
+	printf("\tl : benchmark searches in a skiplist whose number of levels follows its size, and in a skiplist with num levels, growing from 10 to n values\n\t\t(n given as third argument, defaults to 10000000)\n");
+	printf("\tv : benchmark the lookups in ordered maps of n values (n given as third argument, defaults to 1000000) with int, uint64 and untyped keys,\n\t\tand in a skiplist of num levels\n");
+	printf("\ty : benchmark searches and scans in a skiplist and a block skiplist of n values (n given as third argument, defaults to 1000000)\n");
+	printf("\tz : benchmark the aggregation of n values (n given as third argument, defaults to 1000000) by scan, by batches and\n\t\tby the kernels of each implementation on a skiplist and on a block skiplist\n");
+	printf("\tL : benchmark the construction, the save, the load and the mapping of a skiplist of n values (n given as third argument,\n\t\tdefaults to 1000000), and the searches in the loaded list and in the mapped image\n");
+	printf("\tn : benchmark a stream of inserts, 90%% of them duplicates, in a skiplist of num levels\n");
+	printf("\tx : convert the files test_files/construct_num.txt, test_files/search_num.txt and test_files/remove_num.txt to their binary form\n\t\ttest_files/action_num.bin, used from then on while the text files are unchanged, and compare the time to load each form\n");
+	printf("\tt : benchmark mixed searches and updates from 1 to n threads (n given as third argument, defaults to the number of cores)\n\t\ton a concurrent skiplist and on a skiplist protected by a global mutex\n");
 	printf("and num is the file number for input\n");
 }
 
+/** Return the name of the file with the given extension associated with the action to perform and the number of a test.
+ */
+char *gettestfile(const char *action, int numtest, const char *extension) {
+	const char *testdir ="../Test/test_files/";
+	int l = snprintf(NULL, 0, "%s%s_%d.%s", testdir, action, numtest, extension) + 1;
+	char *name = malloc(l*sizeof(char));
+	sprintf(name, "%s%s_%d.%s", testdir, action, numtest, extension);
+	return name;
+}
+
 /** Return the filename associated with the action to perform and the number of a test.
  
  @param action Describe the action associated with the file to load. Must be one of "construct" "search" or "remove"
@@ -50,11 +167,7 @@ void usage(const char *command) {
  
  */
 char *gettestfilename(const char *action, int numtest) {
-	const char *testdir ="../Test/test_files/";
-	int l = strlen(testdir) + strlen(action) + strlen("_xxx.txt");
-	char *name = malloc(l*sizeof(char));
-	sprintf(name, "%s%s_%d.txt", testdir, action, numtest);
-	return name;
+	return gettestfile(action, numtest, "txt");
 }
 
 int read_int(FILE* input) {
@@ -78,28 +191,290 @@ unsigned int read_uint(FILE* input) {
   abort();
 }
 
-/** Build a list corresponding to the fiven file number.
+int compare_values(const void *a, const void *b) {
+	int x = *(const int*)a;
+	int y = *(const int*)b;
+	return (x > y) - (x < y);
+}
+
+/** Content of an input file, mapped in memory when the system allows it, read otherwise.
  */
-SkipList* buildlist(int num) {
-	SkipList* d;
-	FILE *input;
-	
-	char *constructfromfile = gettestfilename("construct", num);
-	input = fopen(constructfromfile, "r");
-	if (input!=NULL) {
-		int size = (int) read_uint(input);
-		d = skiplist_create(size);
-		unsigned int nb_values = read_uint(input);
-		for (unsigned int i=0;i< nb_values; ++i) {
-			d = skiplist_insert(d, read_int(input));
+typedef struct s_MappedFile {
+	char *data;
+	size_t size;
+	bool mapped;
+} MappedFile;
+
+bool map_file(const char *filename, MappedFile *file) {
+#ifndef _WIN32
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat status;
+	if (fstat(fd, &status) == 0 && status.st_size > 0) {
+		void *data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED) {
+			close(fd);
+			file->data = data;
+			file->size = (size_t)status.st_size;
+			file->mapped = true;
+			return true;
 		}
+	}
+	close(fd);
+#endif
+	FILE *input = fopen(filename, "rb");
+	if (input == NULL) {
+		return false;
+	}
+	fseek(input, 0, SEEK_END);
+	long size = ftell(input);
+	rewind(input);
+	file->data = malloc((size_t)size + 1);
+	file->size = fread(file->data, 1, (size_t)size, input);
+	file->mapped = false;
+	fclose(input);
+	return true;
+}
+
+void unmap_file(MappedFile *file) {
+#ifndef _WIN32
+	if (file->mapped) {
+		munmap(file->data, file->size);
+		return;
+	}
+#endif
+	free(file->data);
+}
+
+/** Parse the next decimal integer of [*cursor, end), skipping the white space before it, as fscanf("%d") does.
+ @return false if there is no integer left, if the next characters are not an integer, or if it does not fit in an int.
+ */
+bool parse_int(const char **cursor, const char *end, int *value) {
+	const char *p = *cursor;
+	while (p < end && isspace((unsigned char)*p)) {
+		++p;
+	}
+	bool negative = p < end && *p == '-';
+	if (p < end && (*p == '-' || *p == '+')) {
+		++p;
+	}
+	const char *digits = p;
+	const long long int bound = negative ? -(long long int)INT_MIN : INT_MAX;
+	long long int v = 0;
+	for (unsigned int digit; p < end && (digit = (unsigned int)(*p - '0')) <= 9; ++p) {
+		v = v * 10 + digit;
+		if (v > bound) {
+			return false;
+		}
+	}
+	if (p == digits) {
+		return false;
+	}
+	*value = (int)(negative ? -v : v);
+	*cursor = p;
+	return true;
+}
+
+/** Binary test files : a header of four little endian 32 bits words, then the values as little endian 32 bits integers.
+ The header holds the magic number BINARY_MAGIC ("SKLB"), the number of levels (0 but for construct files), the number of values
+ and the size of the text file the values come from. A binary file is used in place of its text file only when it is not older
+ than the text file and was written from a text file of the same size : a stale binary file is ignored.
+ */
+#define BINARY_MAGIC 0x424C4B53
+#define BINARY_HEADER_WORDS 4
+
+uint32_t read_le32(const unsigned char *bytes) {
+	return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+void write_le32(uint32_t word, FILE *output) {
+	unsigned char bytes[4] = {(unsigned char)word, (unsigned char)(word >> 8), (unsigned char)(word >> 16), (unsigned char)(word >> 24)};
+	fwrite(bytes, 1, 4, output);
+}
+
+bool little_endian_host(void) {
+	const uint32_t one = 1;
+	return *(const unsigned char*)&one == 1;
+}
+
+/** Size of a file, 0 if it does not exist. */
+uint32_t file_size(const char *filename) {
+	struct stat status;
+	return stat(filename, &status) == 0 ? (uint32_t)status.st_size : 0;
+}
+
+void write_binary_values(const char *filename, int nblevels, const int *values, unsigned int nb_values, uint32_t text_size) {
+	FILE *output = fopen(filename, "wb");
+	if (output == NULL) {
+		printf("Unable to open file %s\n", filename);
+		exit (1);
+	}
+	write_le32(BINARY_MAGIC, output);
+	write_le32((uint32_t)nblevels, output);
+	write_le32(nb_values, output);
+	write_le32(text_size, output);
+	if (little_endian_host()) {
+		fwrite(values, sizeof(int), nb_values, output);
 	} else {
-		printf("Unable to open file %s\n", constructfromfile);
-		free(constructfromfile);
+		for (unsigned int i=0; i< nb_values; ++i) {
+			write_le32((uint32_t)values[i], output);
+		}
+	}
+	fclose(output);
+}
+
+/** Values of a test file.
+ A binary file is used in place, while the content of a text file is parsed into an array.
+ */
+typedef struct s_TestValues {
+	const int *values;
+	unsigned int nb_values;
+	int nblevels;
+	MappedFile file;
+	int *parsed;
+	uint32_t text_size;
+} TestValues;
+
+/** Load the values of a text file holding, for construct files, the number of levels, then the number of values and the values. */
+bool load_text_values(const char *filename, bool construct, TestValues *t) {
+	if (!map_file(filename, &t->file)) {
+		return false;
+	}
+	const char *cursor = t->file.data;
+	const char *end = t->file.data + t->file.size;
+	int header[2] = {0, 0};
+	for (int i = !construct; i < 2; ++i) {
+		if (!parse_int(&cursor, end, &header[i])) {
+			perror("Unable to read uint from input file\n");
+			abort();
+		}
+	}
+	t->nblevels = header[0];
+	t->nb_values = (unsigned int)header[1];
+	t->parsed = malloc((t->nb_values + 1)*sizeof(int));
+	for (unsigned int i=0; i< t->nb_values; ++i) {
+		if (!parse_int(&cursor, end, &t->parsed[i])) {
+			perror("Unable to read int from input file\n");
+			abort();
+		}
+	}
+	unmap_file(&t->file);
+	t->file.data = NULL;
+	t->values = t->parsed;
+	return true;
+}
+
+/** Load the values of a binary file, without copy on a little endian host. */
+bool load_binary_values(const char *filename, TestValues *t) {
+	if (!map_file(filename, &t->file)) {
+		return false;
+	}
+	const unsigned char *bytes = (const unsigned char*)t->file.data;
+	size_t header_size = BINARY_HEADER_WORDS * 4;
+	if (t->file.size < header_size || read_le32(bytes) != BINARY_MAGIC
+		|| (t->file.size - header_size) / 4 < read_le32(bytes + 8)) {
+		printf("Invalid binary file %s\n", filename);
 		exit (1);
 	}
-	free(constructfromfile);
-	fclose(input);
+	t->nblevels = (int)read_le32(bytes + 4);
+	t->nb_values = read_le32(bytes + 8);
+	t->text_size = read_le32(bytes + 12);
+	t->parsed = NULL;
+	if (little_endian_host()) {
+		t->values = (const int*)(bytes + header_size);
+	} else {
+		t->parsed = malloc((t->nb_values + 1)*sizeof(int));
+		for (unsigned int i=0; i< t->nb_values; ++i) {
+			t->parsed[i] = (int)read_le32(bytes + header_size + 4*i);
+		}
+		t->values = t->parsed;
+	}
+	return true;
+}
+
+void release_test_values(TestValues *t) {
+	if (t->file.data) {
+		unmap_file(&t->file);
+	}
+	free(t->parsed);
+}
+
+/** Load the values of a test file, from its binary form action_num.bin when it is up to date with action_num.txt,
+ from action_num.txt otherwise.
+ @param action the kind of file to read (see gettestfilename).
+ @param num the number of the file.
+ @param t set to the values of the file, to release with release_test_values.
+ */
+void load_test_values(const char *action, int num, TestValues *t) {
+	char *filename = gettestfilename(action, num);
+	char *binary = gettestfile(action, num, "bin");
+	struct stat text_status;
+	struct stat binary_status;
+	bool has_text = stat(filename, &text_status) == 0;
+	bool loaded = stat(binary, &binary_status) == 0 && (!has_text || binary_status.st_mtime >= text_status.st_mtime)
+		&& load_binary_values(binary, t);
+	free(binary);
+	if (loaded && has_text && t->text_size != (uint32_t)text_status.st_size) {
+		release_test_values(t);
+		loaded = false;
+	}
+	if (loaded) {
+		free(filename);
+		return;
+	}
+	if (!load_text_values(filename, strcmp(action, "construct") == 0, t)) {
+		printf("Unable to open file %s\n", filename);
+		free(filename);
+		exit (1);
+	}
+	free(filename);
+}
+
+/** Read the whole content of a test file : a number of values followed by the values.
+ @param action the kind of file to read (see gettestfilename).
+ @param num the number of the file.
+ @param nb_values set to the number of values read.
+ @return a malloc'ed array of the values.
+ */
+int* read_values(const char *action, int num, unsigned int *nb_values) {
+	TestValues t;
+	load_test_values(action, num, &t);
+	*nb_values = t.nb_values;
+	int *values = malloc((t.nb_values + 1)*sizeof(int));
+	memcpy(values, t.values, t.nb_values*sizeof(int));
+	release_test_values(&t);
+	return values;
+}
+
+/** Read the content of a construct file.
+ @param num the number of the file.
+ @param nblevels set to the number of levels of the list to build.
+ @param nb_values set to the number of values read.
+ @return a malloc'ed array of the values.
+ */
+int* read_construct_values(int num, int *nblevels, unsigned int *nb_values) {
+	TestValues t;
+	load_test_values("construct", num, &t);
+	*nblevels = t.nblevels;
+	*nb_values = t.nb_values;
+	int *values = malloc((t.nb_values + 1)*sizeof(int));
+	memcpy(values, t.values, t.nb_values*sizeof(int));
+	release_test_values(&t);
+	return values;
+}
+
+/** Build a list corresponding to the fiven file number.
+ */
+SkipList* buildlist(int num) {
+	TestValues t;
+	load_test_values("construct", num, &t);
+	SkipList* d = skiplist_create(t.nblevels);
+	for (unsigned int i=0;i< t.nb_values; ++i) {
+		d = skiplist_insert(d, t.values[i]);
+	}
+	release_test_values(&t);
 	return d;
 }
 
@@ -125,154 +500,2370 @@ void test_construction(int num){
  Programming and test of skiplist search operator.
  */
 void test_search(int num){
-	FILE *input;
-	char* construction_from_file = gettestfilename("search", num);
-	input = fopen(construction_from_file, "r");
-	if (input!=NULL) {
-		int nb_searches = (int) read_uint(input);
-		const SkipList* l =  buildlist(num);
-		int nb_found = 0;
-		unsigned int  total_operation = 0;
-		unsigned int min_operation = skiplist_size(l);
-		unsigned int max_operation = 0;
-		for (int i=0;i< nb_searches; ++i) {
-			int value = read_int(input);
-			unsigned int search_start = 0;
-			unsigned int *nboperations = &search_start;
-			if (skiplist_search(l, value, nboperations)){
-				printf("%i -> true\n", value);
-				nb_found += 1;
-			}
-			else{
-				printf("%i -> false\n", value);
-			}
-
-			min_operation = (*nboperations < min_operation)?*nboperations:min_operation;
-			max_operation = (*nboperations > max_operation)?*nboperations:max_operation;
-			total_operation += *nboperations;
+	TestValues searches;
+	load_test_values("search", num, &searches);
+	int nb_searches = (int) searches.nb_values;
+	const SkipList* l =  buildlist(num);
+	int nb_found = 0;
+	unsigned int  total_operation = 0;
+	unsigned int min_operation = skiplist_size(l);
+	unsigned int max_operation = 0;
+	for (int i=0;i< nb_searches; ++i) {
+		int value = searches.values[i];
+		unsigned int search_start = 0;
+		unsigned int *nboperations = &search_start;
+		if (skiplist_search(l, value, nboperations)){
+			printf("%i -> true\n", value);
+			nb_found += 1;
+		}
+		else{
+			printf("%i -> false\n", value);
 		}
-		printf("Statistics : \n");
-		printf("\tSize of the list : %i\n", skiplist_size(l));
-		printf("Search %i values :\n", nb_searches);
-		printf("\tFound %i\n", nb_found);
-		printf("\tNot found %i\n", nb_searches - nb_found);
-		printf("\tMin number of operations %i\n", min_operation);
-		printf("\tMax number of operations %i\n", max_operation);
-		printf("\tMean number of operations %i\n", total_operation/nb_searches);
 
-	} else {
-		printf("Unable to open file %s\n", construction_from_file);
-		free(construction_from_file);
-		exit (1);
+		min_operation = (*nboperations < min_operation)?*nboperations:min_operation;
+		max_operation = (*nboperations > max_operation)?*nboperations:max_operation;
+		total_operation += *nboperations;
 	}
-	free(construction_from_file);
-	fclose(input);
+	printf("Statistics : \n");
+	printf("\tSize of the list : %i\n", skiplist_size(l));
+	printf("Search %i values :\n", nb_searches);
+	printf("\tFound %i\n", nb_found);
+	printf("\tNot found %i\n", nb_searches - nb_found);
+	printf("\tMin number of operations %i\n", min_operation);
+	printf("\tMax number of operations %i\n", max_operation);
+	printf("\tMean number of operations %i\n", total_operation/nb_searches);
+	release_test_values(&searches);
 }
 
 /** Exercice 3.
  Programming and test of naïve search operator using iterators.
  */
 void test_search_iterator(int num){
-	FILE* input;
-	char* construction_from_file = gettestfilename("search", num);
-	input = fopen(construction_from_file, "r");
-	if (input!=NULL) {
-		int nb_searches = (int) read_uint(input);
-		SkipList* l =  buildlist(num);
-		int nb_found = 0;
-		unsigned int  total_operation = 0;
-		unsigned int min_operation = skiplist_size(l);
-		unsigned int max_operation = 0;
-		for (int i=0;i< nb_searches; ++i) {
-			int value = read_int(input);
-			unsigned int search_start = 0;
-			unsigned int *nboperations = &search_start;
-			if (search_iterate_on_skiplist(l, FORWARD_ITERATOR, value, nboperations)){
-				//printf("%i -> true\n", value);
-				nb_found += 1;
-			}
-			else{
-				//printf("%i -> false\n", value);
-			}
-
-			min_operation = (*nboperations < min_operation)?*nboperations:min_operation;
-			max_operation = (*nboperations > max_operation)?*nboperations:max_operation;
-			total_operation += *nboperations;
+	TestValues searches;
+	load_test_values("search", num, &searches);
+	int nb_searches = (int) searches.nb_values;
+	SkipList* l =  buildlist(num);
+	int nb_found = 0;
+	unsigned int  total_operation = 0;
+	unsigned int min_operation = skiplist_size(l);
+	unsigned int max_operation = 0;
+	for (int i=0;i< nb_searches; ++i) {
+		int value = searches.values[i];
+		unsigned int search_start = 0;
+		unsigned int *nboperations = &search_start;
+		if (search_iterate_on_skiplist(l, FORWARD_ITERATOR, value, nboperations)){
+			//printf("%i -> true\n", value);
+			nb_found += 1;
+		}
+		else{
+			//printf("%i -> false\n", value);
 		}
-		printf("Statistics of Iterator Search: \n");
-		printf("\tSize of the list : %i\n", skiplist_size(l));
-		printf("Search %i values :\n", nb_searches);
-		printf("\tFound %i\n", nb_found);
-		printf("\tNot found %i\n", nb_searches - nb_found);
-		printf("\tMin number of operations %i\n", min_operation);
-		printf("\tMax number of operations %i\n", max_operation);
-		printf("\tMean number of operations %i\n", total_operation/nb_searches);
 
-	} else {
-		printf("Unable to open file %s\n", construction_from_file);
-		free(construction_from_file);
-		exit (1);
+		min_operation = (*nboperations < min_operation)?*nboperations:min_operation;
+		max_operation = (*nboperations > max_operation)?*nboperations:max_operation;
+		total_operation += *nboperations;
 	}
-	free(construction_from_file);
-	fclose(input);
-
+	printf("Statistics of Iterator Search: \n");
+	printf("\tSize of the list : %i\n", skiplist_size(l));
+	printf("Search %i values :\n", nb_searches);
+	printf("\tFound %i\n", nb_found);
+	printf("\tNot found %i\n", nb_searches - nb_found);
+	printf("\tMin number of operations %i\n", min_operation);
+	printf("\tMax number of operations %i\n", max_operation);
+	printf("\tMean number of operations %i\n", total_operation/nb_searches);
+	release_test_values(&searches);
 }
 
 /** Exercice 4.
  Programming and test of skiplist remove operator.
  */
 void test_remove(int num){
+	TestValues removes;
+	load_test_values("remove", num, &removes);
+	SkipList* l =  buildlist(num);
+	for (unsigned int i=0;i< removes.nb_values; i++) {
+		l = skiplist_remove(l, removes.values[i]);
+	}
+	printf("Skiplist (%i)\n", skiplist_size((const SkipList*) l));
+	iterate_on_skiplist(l, BACKWARD_ITERATOR, print_list, stdout);
+	skiplist_delete(&l);
+	release_test_values(&removes);
+}
 
-	FILE* input;
-	char* construction_from_file = gettestfilename("remove", num);
-	input = fopen(construction_from_file, "r");
-	if (input!=NULL) {
-		SkipList* l =  buildlist(num);
-		//printf("Skiplist (%i)\n", skiplist_size((const SkipList*) l));
-		
-		//printf("\n");
-		int nb_to_delete = (int) read_uint(input);
-        //printf("Remove %i values\n", nb_to_delete);
-		for (int i=0;i< nb_to_delete; i++) {
-			int value = read_int(input);
-			l = skiplist_remove(l, value);
+/** Check of the positional access.
+ */
+bool check_positions(SkipList* l){
+	SkipListIterator* e = skiplist_iterator_create(l, FORWARD_ITERATOR);
+	int i = 0;
+	bool consistent = true;
+	for (e = skiplist_iterator_begin(e); !skiplist_iterator_end(e); e = skiplist_iterator_next(e), ++i) {
+		int value = skiplist_iterator_value(e);
+		consistent = consistent && (skiplist_at(l, (unsigned int)i) == value) && (skiplist_rank(l, value) == i);
+	}
+	skiplist_iterator_delete(&e);
+	return consistent;
+}
+
+void test_rank(int num){
+	SkipList* l = buildlist(num);
+	printf("Skiplist (%i)\n", skiplist_size(l));
+	printf("Percentiles :");
+	for (unsigned int p = 0; p <= 100; p += 25) {
+		unsigned int i = p * (skiplist_size(l) - 1) / 100;
+		printf(" %u%%=%d", p, skiplist_at(l, i));
+	}
+	printf("\n");
+	printf("\tat and rank consistent : %s\n", check_positions(l) ? "yes" : "no");
+	unsigned int nb_values;
+	int *values = read_values("remove", num, &nb_values);
+	bool absent_ranks = true;
+	for (unsigned int i=0; i< nb_values; ++i) {
+		l = skiplist_remove(l, values[i]);
+		absent_ranks = absent_ranks && (skiplist_rank(l, values[i]) == -1);
+	}
+	printf("Remove %u values\n", nb_values);
+	printf("\tremoved values have no rank : %s\n", absent_ranks ? "yes" : "no");
+	printf("\tat and rank consistent : %s\n", check_positions(l) ? "yes" : "no");
+	free(values);
+	skiplist_delete(&l);
+}
+
+/** Batched search.
+ Compare the number of tested nodes when searching the values of test_files/search_num.txt one by one,
+ as a batch in the order of the file and as a sorted batch.
+ */
+unsigned int total_operations(const unsigned int *ops, unsigned int n){
+	unsigned int total = 0;
+	for (unsigned int i=0; i< n; ++i) {
+		total += ops[i];
+	}
+	return total;
+}
+
+void test_search_batch(int num){
+	SkipList* l = buildlist(num);
+	unsigned int nb_searches;
+	int *searches = read_values("search", num, &nb_searches);
+	bool *found = malloc(nb_searches*sizeof(bool));
+	bool *found_batch = malloc(nb_searches*sizeof(bool));
+	unsigned int *ops = malloc(nb_searches*sizeof(unsigned int));
+	unsigned int nb_found = 0;
+	for (unsigned int i=0; i< nb_searches; ++i) {
+		ops[i] = 0;
+		found[i] = skiplist_search(l, searches[i], &ops[i]);
+		nb_found += found[i];
+	}
+	printf("Search %u values in a list of size %u\n", nb_searches, skiplist_size(l));
+	printf("\tFound %u\n", nb_found);
+	printf("\tOne by one : %u operations\n", total_operations(ops, nb_searches));
+	skiplist_search_batch(l, searches, nb_searches, found_batch, ops);
+	printf("\tBatch : %u operations, same results %s\n", total_operations(ops, nb_searches),
+		memcmp(found, found_batch, nb_searches*sizeof(bool)) == 0 ? "yes" : "no");
+	qsort(searches, nb_searches, sizeof(int), compare_values);
+	for (unsigned int i=0; i< nb_searches; ++i) {
+		unsigned int nb_operations = 0;
+		found[i] = skiplist_search(l, searches[i], &nb_operations);
+	}
+	skiplist_search_batch(l, searches, nb_searches, found_batch, ops);
+	printf("\tSorted batch : %u operations, same results %s\n", total_operations(ops, nb_searches),
+		memcmp(found, found_batch, nb_searches*sizeof(bool)) == 0 ? "yes" : "no");
+	free(searches);
+	free(found);
+	free(found_batch);
+	free(ops);
+	skiplist_delete(&l);
+}
+
+/** Prefetching searches.
+ Search the values of test_files/search_num.txt with skiplist_search_prefetch and skiplist_search_interleaved,
+ which must find the same values with the same number of operations as skiplist_search.
+ */
+void test_prefetch(int num){
+	SkipList* l = buildlist(num);
+	unsigned int nb_searches;
+	int *searches = read_values("search", num, &nb_searches);
+	bool *found = malloc((nb_searches + 1)*sizeof(bool));
+	bool *found_interleaved = malloc((nb_searches + 1)*sizeof(bool));
+	unsigned int *ops = malloc((nb_searches + 1)*sizeof(unsigned int));
+	unsigned int *ops_interleaved = malloc((nb_searches + 1)*sizeof(unsigned int));
+	unsigned int nb_found = 0;
+	bool same_prefetch = true;
+	for (unsigned int i=0; i< nb_searches; ++i) {
+		unsigned int nb_operations = 0;
+		ops[i] = 0;
+		found[i] = skiplist_search(l, searches[i], &ops[i]);
+		nb_found += found[i];
+		same_prefetch = same_prefetch && skiplist_search_prefetch(l, searches[i], &nb_operations) == found[i]
+			&& nb_operations == ops[i];
+	}
+	skiplist_search_interleaved(l, searches, nb_searches, found_interleaved, ops_interleaved);
+	printf("Search %u values in a list of size %u\n", nb_searches, skiplist_size(l));
+	printf("\tFound %u in %u operations\n", nb_found, total_operations(ops, nb_searches));
+	printf("\tSame results and operations with prefetching : %s\n", same_prefetch ? "yes" : "no");
+	printf("\tSame results and operations by interleaved searches : %s\n",
+		memcmp(found, found_interleaved, nb_searches*sizeof(bool)) == 0
+		&& memcmp(ops, ops_interleaved, nb_searches*sizeof(unsigned int)) == 0 ? "yes" : "no");
+	free(searches);
+	free(found);
+	free(found_interleaved);
+	free(ops);
+	free(ops_interleaved);
+	skiplist_delete(&l);
+}
+
+/** Range operators.
+ Scan, seek and remove the window [first quartile, third quartile) and compare with a full scan of the list.
+ */
+typedef struct s_Window {
+	int lo;
+	int hi;
+	unsigned int count;
+	long long sum;
+} Window;
+
+void count_in_window(int i, void* environment){
+	Window *w = (Window*)environment;
+	if (w->lo <= i && i < w->hi) {
+		w->count += 1;
+		w->sum += i;
+	}
+}
+
+void test_range(int num){
+	SkipList* l = buildlist(num);
+	unsigned int size = skiplist_size(l);
+	Window range = {skiplist_at(l, size/4), skiplist_at(l, 3*size/4), 0, 0};
+	Window scan = range;
+	skiplist_range_map(l, range.lo, range.hi, count_in_window, &range);
+	skiplist_map(l, count_in_window, &scan);
+	printf("Skiplist (%u)\n", size);
+	printf("Window [%d, %d) : %u values, sum %lld, same as full scan %s\n", range.lo, range.hi, range.count, range.sum,
+		(range.count == scan.count && range.sum == scan.sum) ? "yes" : "no");
+	SkipListIterator* e = skiplist_iterator_create(l, FORWARD_ITERATOR);
+	e = skiplist_iterator_seek(e, range.lo + 1);
+	printf("\tForward seek of %d : %d\n", range.lo + 1, skiplist_iterator_value(e));
+	skiplist_iterator_delete(&e);
+	e = skiplist_iterator_create(l, BACKWARD_ITERATOR);
+	e = skiplist_iterator_seek(e, range.hi - 1);
+	printf("\tBackward seek of %d : %d\n", range.hi - 1, skiplist_iterator_value(e));
+	skiplist_iterator_delete(&e);
+	l = skiplist_remove_range(l, range.lo, range.hi);
+	Window after = {range.lo, range.hi, 0, 0};
+	skiplist_map(l, count_in_window, &after);
+	printf("Remove window\n");
+	printf("Skiplist (%u)\n", skiplist_size(l));
+	printf("\twindow is empty : %s\n", after.count == 0 ? "yes" : "no");
+	printf("\tat and rank consistent : %s\n", check_positions(l) ? "yes" : "no");
+	iterate_on_skiplist(l, BACKWARD_ITERATOR, print_list, stdout);
+	printf("\n");
+	skiplist_delete(&l);
+}
+
+/** Check of the search complexity.
+ With levels levels and n values, a search is expected to compare about 2 nodes per useful level,
+ the useful levels being bounded by log2(n)+1, plus a scan of the n/2^(levels-1) towers of the top level.
+ */
+void test_complexity(int num){
+	int levels;
+	unsigned int nb_values;
+	free(read_construct_values(num, &levels, &nb_values));
+	SkipList* l = buildlist(num);
+	int *searches = read_values("search", num, &nb_values);
+	unsigned int total_operation = 0;
+	for (unsigned int i=0; i< nb_values; ++i) {
+		unsigned int nb_operations = 0;
+		skiplist_search(l, searches[i], &nb_operations);
+		total_operation += nb_operations;
+	}
+	double n = skiplist_size(l);
+	double useful_levels = fmin(levels, log2(n) + 1);
+	double bound = 2 * (useful_levels + 1) + n / pow(2, levels - 1);
+	double mean = (double) total_operation / nb_values;
+	printf("Search %u values in a list of size %u\n", nb_values, skiplist_size(l));
+	printf("\tMean number of operations within O(log n) : %s\n", mean <= bound ? "yes" : "no");
+	skiplist_delete(&l);
+	free(searches);
+}
+
+/** Benchmark of the tower allocators.
+ Insert then remove, several times, all the values of test_files/remove_num.txt and report the throughput of each allocator.
+ */
+#define CHURN_LEVELS 16
+#define CHURN_ROUNDS 4
+
+double churn(const int *values, unsigned int nb_values, SkipListAllocator allocator){
+	clock_t start = clock();
+	SkipList* l = skiplist_create_with_allocator(CHURN_LEVELS, allocator);
+	for (int round = 0; round < CHURN_ROUNDS; ++round) {
+		for (unsigned int i=0; i< nb_values; ++i) {
+			l = skiplist_insert(l, values[i]);
+		}
+		for (unsigned int i=0; i< nb_values; ++i) {
+			l = skiplist_remove(l, values[nb_values-1-i]);
+		}
+	}
+	for (unsigned int i=0; i< nb_values; ++i) {
+		l = skiplist_insert(l, values[i]);
+	}
+	skiplist_delete(&l);
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+void bench_allocators(int num){
+	unsigned int nb_values;
+	int *values = read_values("remove", num, &nb_values);
+	double operations = (2.0 * CHURN_ROUNDS + 1) * nb_values;
+	double malloc_time = churn(values, nb_values, MALLOC_ALLOCATOR);
+	double arena_time = churn(values, nb_values, ARENA_ALLOCATOR);
+	printf("Churn of %u values (%d rounds)\n", nb_values, CHURN_ROUNDS);
+	printf("\tmalloc : %.3f s, %.0f operations/s\n", malloc_time, operations / malloc_time);
+	printf("\tarena  : %.3f s, %.0f operations/s\n", arena_time, operations / arena_time);
+	free(values);
+}
+
+/** Benchmark of the bulk loading.
+ Build the list of test_files/construct_num.txt by repeated inserts, by skiplist_build_from_array and
+ by skiplist_build_balanced_from_array, enough times to process about BUILD_VALUES values.
+ */
+#define BUILD_VALUES 4000000
+
+void store_value(int i, void* environment){
+	int **cursor = (int**)environment;
+	*(*cursor)++ = i;
+}
+
+bool same_content(SkipList* a, SkipList* b){
+	if (skiplist_size(a) != skiplist_size(b)) {
+		return false;
+	}
+	int *content_a = malloc((skiplist_size(a) + 1)*sizeof(int));
+	int *content_b = malloc((skiplist_size(b) + 1)*sizeof(int));
+	int *cursor = content_a;
+	skiplist_map(a, store_value, &cursor);
+	cursor = content_b;
+	skiplist_map(b, store_value, &cursor);
+	bool same = memcmp(content_a, content_b, skiplist_size(a)*sizeof(int)) == 0;
+	free(content_a);
+	free(content_b);
+	return same;
+}
+
+SkipList* build_by_inserts(const int *values, unsigned int nb_values, int levels){
+	SkipList* l = skiplist_create(levels);
+	for (unsigned int i=0; i< nb_values; ++i) {
+		l = skiplist_insert(l, values[i]);
+	}
+	return l;
+}
+
+void bench_build(int num){
+	int levels;
+	unsigned int nb_values;
+	int *values = read_construct_values(num, &levels, &nb_values);
+	int rounds = nb_values < BUILD_VALUES ? BUILD_VALUES / nb_values : 1;
+	SkipList* reference = build_by_inserts(values, nb_values, levels);
+	SkipList* l = NULL;
+	double times[3];
+	bool same[3];
+	for (int method = 0; method < 3; ++method) {
+		clock_t start = clock();
+		for (int round = 0; round < rounds; ++round) {
+			if (l) {
+				skiplist_delete(&l);
+			}
+			if (method == 0) {
+				l = build_by_inserts(values, nb_values, levels);
+			} else if (method == 1) {
+				l = skiplist_build_from_array(values, nb_values, levels);
+			} else {
+				l = skiplist_build_balanced_from_array(values, nb_values, levels);
+			}
 		}
-		printf("Skiplist (%i)\n", skiplist_size((const SkipList*) l));
-		iterate_on_skiplist(l, BACKWARD_ITERATOR, print_list, stdout);
+		times[method] = (double)(clock() - start) / CLOCKS_PER_SEC / rounds;
+		same[method] = same_content(reference, l) && check_positions(l);
 		skiplist_delete(&l);
+	}
+	printf("Build a list of %u values (%i levels, %d rounds)\n", nb_values, levels, rounds);
+	printf("\trepeated inserts : %.6f s, same content %s\n", times[0], same[0] ? "yes" : "no");
+	printf("\tbulk load        : %.6f s, same content %s\n", times[1], same[1] ? "yes" : "no");
+	printf("\tbalanced load    : %.6f s, same content %s\n", times[2], same[2] ? "yes" : "no");
+	skiplist_delete(&reference);
+	free(values);
+}
 
-	} else {
-		printf("Unable to open file %s\n", construction_from_file);
-		free(construction_from_file);
-		exit (1);
+/** Adaptive number of levels.
+ Build a skiplist created with 0 levels from test_files/construct_num.txt, compare it to the list built with the levels
+ of the file, check the positions and the number of operations of the searches of test_files/search_num.txt,
+ then remove the values of test_files/remove_num.txt and check again.
+ */
+bool logarithmic_searches(SkipList* l, const int *searches, unsigned int nb_searches){
+	unsigned int total_operation = 0;
+	for (unsigned int i=0; i< nb_searches; ++i) {
+		unsigned int nb_operations = 0;
+		skiplist_search(l, searches[i], &nb_operations);
+		total_operation += nb_operations;
 	}
-	free(construction_from_file);
-	fclose(input);
-	
+	// the height follows log2(n) : the levels never run out as in test_complexity
+	double n = skiplist_size(l);
+	double bound = 2 * (log2(n + 1) + 2) + 1;
+	return (double) total_operation / nb_searches <= bound;
 }
 
-/** Function you can use to generate dataset for testing.
+void test_adaptive(int num){
+	int levels;
+	unsigned int nb_values;
+	int *values = read_construct_values(num, &levels, &nb_values);
+	SkipList* reference = build_by_inserts(values, nb_values, levels);
+	SkipList* l = build_by_inserts(values, nb_values, 0);
+	SkipList* loaded = skiplist_build_from_array(values, nb_values, 0);
+	free(values);
+	unsigned int nb_searches;
+	int *searches = read_values("search", num, &nb_searches);
+	printf("Skiplist of size %u with adaptive levels\n", skiplist_size(l));
+	printf("\tSame content as with %d levels : %s\n", levels, same_content(reference, l) ? "yes" : "no");
+	printf("\tBulk loaded with the same content : %s\n", same_content(reference, loaded) && check_positions(loaded) ? "yes" : "no");
+	printf("\tConsistent positions : %s\n", check_positions(l) ? "yes" : "no");
+	printf("\tMean number of operations within O(log n) : %s\n", logarithmic_searches(l, searches, nb_searches) ? "yes" : "no");
+	values = read_values("remove", num, &nb_values);
+	for (unsigned int i=0; i< nb_values; ++i) {
+		reference = skiplist_remove(reference, values[i]);
+		l = skiplist_remove(l, values[i]);
+	}
+	printf("Skiplist of size %u after removals\n", skiplist_size(l));
+	printf("\tSame content as with %d levels : %s\n", levels, same_content(reference, l) ? "yes" : "no");
+	printf("\tConsistent positions : %s\n", check_positions(l) ? "yes" : "no");
+	printf("\tMean number of operations within O(log n) : %s\n", logarithmic_searches(l, searches, nb_searches) ? "yes" : "no");
+	skiplist_delete(&reference);
+	skiplist_delete(&l);
+	skiplist_delete(&loaded);
+	free(searches);
+	free(values);
+}
+
+/** Searches in a growing skiplist.
+ Insert distinct keys in a list created with 0 levels and in a list with the given levels, and at each power of 10,
+ time GROWTH_SEARCHES searches of inserted keys. The list with fixed levels is dropped once its searches get too slow.
  */
-void generate(int nbvalues);
+#define GROWTH_SEARCHES 100000
+#define GROWTH_FIXED_MAX 100000
 
+unsigned int growth_key(unsigned int i){
+	// multiplication by an odd constant permutes the 32 bits integers : distinct keys in a pseudo random order
+	return i * 2654435761u;
+}
 
-int main(int argc, const char *argv[]){
-	if (argc < 3) {
-		usage(argv[0]);
-		return 1;
+void growth_searches(SkipList* l, unsigned int n, double *mean_operations, double *time){
+	unsigned long long int total_operation = 0;
+	clock_t start = clock();
+	for (unsigned int i=0; i< GROWTH_SEARCHES; ++i) {
+		unsigned int nb_operations = 0;
+		skiplist_search(l, (int)growth_key((unsigned int)(i * 7919ULL % n)), &nb_operations);
+		total_operation += nb_operations;
 	}
-	switch (argv[1][1]) {
-		case 'c' :
-			test_construction(atoi(argv[2]));
-			break;
-		case 's' :
-			test_search(atoi(argv[2]));
-			break;
-		case 'i' :
-			test_search_iterator(atoi(argv[2]));
-			break;
-		case 'r' :
-			test_remove(atoi(argv[2]));
+	*time = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / GROWTH_SEARCHES;
+	*mean_operations = (double)total_operation / GROWTH_SEARCHES;
+}
+
+void bench_growth(int levels, unsigned int max_size){
+	SkipList* adaptive = skiplist_create_with_allocator(0, ARENA_ALLOCATOR);
+	SkipList* fixed = skiplist_create_with_allocator(levels, ARENA_ALLOCATOR);
+	printf("Mean operations (ns) per search, %d searches\n", GROWTH_SEARCHES);
+	printf("size\tlog2(n)\tadaptive\t\t%d levels\n", levels);
+	unsigned int n = 0;
+	for (unsigned long long int size = 10; size <= max_size; size *= 10) {
+		for (; n < size; ++n) {
+			adaptive = skiplist_insert(adaptive, (int)growth_key(n));
+			if (fixed) {
+				fixed = skiplist_insert(fixed, (int)growth_key(n));
+			}
+		}
+		double operations, time;
+		growth_searches(adaptive, n, &operations, &time);
+		printf("%u\t%.1f\t%.1f (%.0f ns)", n, log2(n), operations, time);
+		if (fixed) {
+			growth_searches(fixed, n, &operations, &time);
+			printf("\t%.1f (%.0f ns)", operations, time);
+			if (n >= GROWTH_FIXED_MAX) {
+				skiplist_delete(&fixed);
+			}
+		} else {
+			printf("\t-");
+		}
+		printf("\n");
+	}
+	skiplist_delete(&adaptive);
+	if (fixed) {
+		skiplist_delete(&fixed);
+	}
+}
+
+/** Statistics.
+ Print the list built from test_files/construct_num.txt level by level, and check its statistics against a search
+ of each of its values, before and after removing the values of test_files/remove_num.txt.
+ */
+typedef struct s_PathCheck{
+	SkipList* list;
+	unsigned long long int total;
+	unsigned int max;
+} PathCheck;
+
+void search_path(int value, void* environment){
+	PathCheck* check = environment;
+	unsigned int nb_operations = 0;
+	skiplist_search(check->list, value, &nb_operations);
+	check->total += nb_operations;
+	if (nb_operations > check->max) {
+		check->max = nb_operations;
+	}
+}
+
+bool check_stats(SkipList* l){
+	SkipListStats stats;
+	skiplist_stats(l, &stats);
+	PathCheck check = {l, 0, 0};
+	skiplist_map(l, search_path, &check);
+	double average = stats.size ? (double)check.total / stats.size : 0;
+	bool valid = stats.size == skiplist_size(l) && fabs(stats.average_search_path - average) < 1e-9 && stats.max_search_path == check.max;
+	unsigned int towers = 0;
+	for (int i = SKIPLIST_MAX_LEVEL-1; i >= 0; --i) {
+		towers += stats.height_histogram[i];
+		valid = valid && stats.nodes_per_level[i] == (i < stats.level ? towers : 0);
+	}
+	valid = valid && towers == stats.size;
+	if (stats.counters_enabled) {
+		valid = valid && stats.nb_inserts - stats.nb_removes == stats.size;
+	}
+	return valid;
+}
+
+void test_stats(int num){
+	SkipList* l = buildlist(num);
+	printbylevel(l);
+	printf("\tConsistent statistics : %s\n", check_stats(l) ? "yes" : "no");
+	unsigned int nb_values;
+	int *values = read_values("remove", num, &nb_values);
+	for (unsigned int i=0; i< nb_values; ++i) {
+		l = skiplist_remove(l, values[i]);
+	}
+	printbylevel(l);
+	printf("\tConsistent statistics : %s\n", check_stats(l) ? "yes" : "no");
+	skiplist_delete(&l);
+	free(values);
+}
+
+/** Ordered maps.
+ Map each value of test_files/construct_num.txt to its index in the file, with a map of int keys and a map of untyped keys
+ pointing to the values, then erase the values of test_files/remove_num.txt. Each payload must designate its key, and
+ the map is printed as in test_remove.
+ */
+SKIPLIST_DEFINE(intmap, int, unsigned int, SKIPLIST_COMPARE_NUMBERS)
+SKIPLIST_DEFINE(uint64map, uint64_t, uint64_t, SKIPLIST_COMPARE_NUMBERS)
+
+void store_key(int key, unsigned int *payload, void* environment){
+	(void)payload;
+	store_value(key, environment);
+}
+
+void test_map(int num){
+	int levels;
+	unsigned int nb_values;
+	int *values = read_construct_values(num, &levels, &nb_values);
+	intmap* m = intmap_create(levels);
+	SkipListMap* g = skiplistmap_create_with_comparator(0, compare_values);
+	bool payloads = true;
+	for (unsigned int i=0; i< nb_values; ++i) {
+		payloads = payloads && *intmap_put(m, values[i], i) == i;
+		skiplistmap_put(g, &values[i], &values[i]);
+	}
+	for (unsigned int i=0; i< nb_values; ++i) {
+		// the payload of a duplicated value is the index of its last occurrence
+		unsigned int *index = intmap_get(m, values[i]);
+		payloads = payloads && index && *index >= i && values[*index] == values[i];
+		void **value = skiplistmap_get(g, &values[i]);
+		payloads = payloads && value && *(int*)*value == values[i];
+	}
+	unsigned int nb_removes;
+	int *removes = read_values("remove", num, &nb_removes);
+	for (unsigned int i=0; i< nb_removes; ++i) {
+		unsigned int index;
+		if (intmap_erase(m, removes[i], &index)) {
+			payloads = payloads && values[index] == removes[i];
+		}
+		skiplistmap_erase(g, &removes[i], NULL);
+		payloads = payloads && !intmap_get(m, removes[i]) && !skiplistmap_get(g, &removes[i]);
+	}
+	if (!payloads || intmap_size(m) != skiplistmap_size(g)) {
+		printf("Inconsistent payloads\n");
+	}
+	unsigned int size = intmap_size(m);
+	int *content = malloc((size + 1)*sizeof(int));
+	int *cursor = content;
+	intmap_map(m, store_key, &cursor);
+	printf("Skiplist (%u)\n", size);
+	while (cursor != content) {
+		print_list(*--cursor, stdout);
+	}
+	free(content);
+	free(removes);
+	intmap_delete(&m);
+	skiplistmap_delete(&g);
+	free(values);
+}
+
+/** Lookups in ordered maps.
+ Time MAP_LOOKUPS lookups in maps of nb_values distinct keys with an inlined comparison of int and uint64 keys,
+ with a comparator called through a pointer on untyped keys, and in a skiplist holding the keys only.
+ */
+#define MAP_LOOKUPS 1000000
+
+double elapsed_ns(clock_t start){
+	return (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / MAP_LOOKUPS;
+}
+
+void bench_map(int levels, unsigned int nb_values){
+	int *keys = malloc(nb_values*sizeof(int));
+	intmap* m = intmap_create(0);
+	uint64map* m64 = uint64map_create(0);
+	SkipListMap* g = skiplistmap_create_with_comparator(0, compare_values);
+	SkipList* l = skiplist_create(levels);
+	for (unsigned int i=0; i< nb_values; ++i) {
+		keys[i] = (int)growth_key(i);
+		intmap_put(m, keys[i], i);
+		uint64map_put(m64, (uint64_t)keys[i], i);
+		skiplistmap_put(g, &keys[i], &keys[i]);
+		l = skiplist_insert(l, keys[i]);
+	}
+	unsigned long long int found = 0;
+	printf("Lookup %d keys among %u\n", MAP_LOOKUPS, nb_values);
+	clock_t start = clock();
+	for (unsigned int i=0; i< MAP_LOOKUPS; ++i) {
+		found += intmap_get(m, keys[i * 7919ULL % nb_values]) != NULL;
+	}
+	printf("\tint keys      : %.0f ns\n", elapsed_ns(start));
+	start = clock();
+	for (unsigned int i=0; i< MAP_LOOKUPS; ++i) {
+		found += uint64map_get(m64, (uint64_t)keys[i * 7919ULL % nb_values]) != NULL;
+	}
+	printf("\tuint64 keys   : %.0f ns\n", elapsed_ns(start));
+	start = clock();
+	for (unsigned int i=0; i< MAP_LOOKUPS; ++i) {
+		found += skiplistmap_get(g, &keys[i * 7919ULL % nb_values]) != NULL;
+	}
+	printf("\tuntyped keys  : %.0f ns\n", elapsed_ns(start));
+	start = clock();
+	for (unsigned int i=0; i< MAP_LOOKUPS; ++i) {
+		unsigned int nb_operations = 0;
+		found += skiplist_search(l, keys[i * 7919ULL % nb_values], &nb_operations);
+	}
+	printf("\tskiplist (%d levels, no payload) : %.0f ns\n", levels, elapsed_ns(start));
+	printf("%llu keys found\n", found);
+	intmap_delete(&m);
+	uint64map_delete(&m64);
+	skiplistmap_delete(&g);
+	skiplist_delete(&l);
+	free(keys);
+}
+
+/** Block skiplist.
+ Same as test_remove with a block skiplist, then check it against a skiplist through BLOCK_CHURN random inserts and removes
+ of BLOCK_CHURN_KEYS keys, splitting and merging many blocks.
+ */
+#define BLOCK_CHURN 200000
+#define BLOCK_CHURN_KEYS 8192
+
+bool same_block_content(SkipList* l, BlockSkipList* b){
+	if (skiplist_size(l) != block_skiplist_size(b)) {
+		return false;
+	}
+	SkipListIterator* e = skiplist_iterator_create(l, BACKWARD_ITERATOR);
+	BlockSkipListIterator* it = block_skiplist_iterator_create(b, BACKWARD_ITERATOR);
+	unsigned int i = skiplist_size(l);
+	bool same = true;
+	for (e = skiplist_iterator_begin(e); same && !skiplist_iterator_end(e); e = skiplist_iterator_next(e), it = block_skiplist_iterator_next(it)) {
+		int value = skiplist_iterator_value(e);
+		--i;
+		same = !block_skiplist_iterator_end(it) && block_skiplist_iterator_value(it) == value
+			&& block_skiplist_at(b, i) == value && block_skiplist_rank(b, value) == (int)i;
+	}
+	same = same && block_skiplist_iterator_end(it);
+	skiplist_iterator_delete(&e);
+	block_skiplist_iterator_delete(&it);
+	int *content = malloc((skiplist_size(l) + 1)*sizeof(int));
+	int *cursor = content;
+	block_skiplist_map(b, store_value, &cursor);
+	for (i = 0; same && i < skiplist_size(l); ++i) {
+		same = content[i] == skiplist_at(l, i);
+	}
+	free(content);
+	return same;
+}
+
+bool same_seek(SkipList* l, BlockSkipList* b, int value){
+	bool same = true;
+	for (IteratorDirection direction = BACKWARD_ITERATOR; direction <= FORWARD_ITERATOR; ++direction) {
+		SkipListIterator* e = skiplist_iterator_seek(skiplist_iterator_create(l, direction), value);
+		BlockSkipListIterator* it = block_skiplist_iterator_seek(block_skiplist_iterator_create(b, direction), value);
+		same = same && skiplist_iterator_end(e) == block_skiplist_iterator_end(it)
+			&& (skiplist_iterator_end(e) || skiplist_iterator_value(e) == block_skiplist_iterator_value(it));
+		skiplist_iterator_delete(&e);
+		block_skiplist_iterator_delete(&it);
+	}
+	return same;
+}
+
+void test_block(int num){
+	int levels;
+	unsigned int nb_values;
+	int *values = read_construct_values(num, &levels, &nb_values);
+	BlockSkipList* b = block_skiplist_create(levels);
+	for (unsigned int i=0; i< nb_values; ++i) {
+		b = block_skiplist_insert(b, values[i]);
+	}
+	free(values);
+	values = read_values("remove", num, &nb_values);
+	for (unsigned int i=0; i< nb_values; ++i) {
+		b = block_skiplist_remove(b, values[i]);
+	}
+	free(values);
+	printf("Skiplist (%u)\n", block_skiplist_size(b));
+	BlockSkipListIterator* it = block_skiplist_iterator_create(b, BACKWARD_ITERATOR);
+	for (it = block_skiplist_iterator_begin(it); !block_skiplist_iterator_end(it); it = block_skiplist_iterator_next(it)) {
+		print_list(block_skiplist_iterator_value(it), stdout);
+	}
+	block_skiplist_iterator_delete(&it);
+	block_skiplist_delete(&b);
+
+	SkipList* l = skiplist_create(levels);
+	b = block_skiplist_create(0);
+	bool consistent = true;
+	uint64_t state = (uint64_t)num;
+	for (unsigned int i=0; consistent && i< BLOCK_CHURN; ++i) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		int value = (int)((state >> 33) % BLOCK_CHURN_KEYS);
+		if ((state >> 32) & 1) {
+			l = skiplist_insert(l, value);
+			b = block_skiplist_insert(b, value);
+		} else {
+			l = skiplist_remove(l, value);
+			b = block_skiplist_remove(b, value);
+		}
+		unsigned int nb_operations = 0;
+		consistent = skiplist_search(l, value + 1, &nb_operations) == block_skiplist_search(b, value + 1, &nb_operations)
+			&& same_seek(l, b, value);
+		if (i % 1000 == 0) {
+			consistent = consistent && same_block_content(l, b);
+		}
+	}
+	consistent = consistent && same_block_content(l, b);
+	nb_values = skiplist_size(l);
+	values = malloc((nb_values + 1)*sizeof(int));
+	int *cursor = values;
+	skiplist_map(l, store_value, &cursor);
+	BlockSkipList* loaded = block_skiplist_build_from_array(values, nb_values, 0);
+	consistent = consistent && same_block_content(l, loaded);
+	for (unsigned int i=0; i< nb_values; i += 2) {
+		loaded = block_skiplist_remove(loaded, values[i]);
+		l = skiplist_remove(l, values[i]);
+	}
+	consistent = consistent && same_block_content(l, loaded);
+	if (!consistent) {
+		printf("Inconsistent block skiplist\n");
+	}
+	free(values);
+	skiplist_delete(&l);
+	block_skiplist_delete(&b);
+	block_skiplist_delete(&loaded);
+}
+
+/** Block skiplist lookups and scans.
+ Time MAP_LOOKUPS searches and a full scan in a skiplist and in a block skiplist bulk loaded with the same nb_values keys,
+ then built by inserts, and report the bytes per key of each.
+ */
+void sum_values(int value, void* environment){
+	*(long long int*)environment += value;
+}
+
+void bench_block(unsigned int nb_values){
+	int *keys = malloc(nb_values*sizeof(int));
+	for (unsigned int i=0; i< nb_values; ++i) {
+		keys[i] = (int)growth_key(i);
+	}
+	printf("Search %d keys among %u, scan them, bytes per key\n", MAP_LOOKUPS, nb_values);
+	for (int inserted = 0; inserted < 2; ++inserted) {
+		SkipList* l;
+		BlockSkipList* b;
+		if (inserted) {
+			l = skiplist_create(0);
+			b = block_skiplist_create(0);
+			for (unsigned int i=0; i< nb_values; ++i) {
+				l = skiplist_insert(l, keys[i]);
+				b = block_skiplist_insert(b, keys[i]);
+			}
+		} else {
+			l = skiplist_build_from_array(keys, nb_values, 0);
+			b = block_skiplist_build_from_array(keys, nb_values, 0);
+		}
+		SkipListStats stats;
+		skiplist_stats(l, &stats);
+		unsigned long long int found = 0;
+		long long int sum = 0;
+		clock_t start = clock();
+		for (unsigned int i=0; i< MAP_LOOKUPS; ++i) {
+			unsigned int nb_operations = 0;
+			found += skiplist_search(l, keys[i * 7919ULL % nb_values], &nb_operations);
+		}
+		double search = elapsed_ns(start);
+		start = clock();
+		skiplist_map(l, sum_values, &sum);
+		double scan = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / nb_values;
+		printf("\tskiplist, %s : %.0f ns, %.1f ns, %.1f bytes\n", inserted ? "inserts" : "bulk   ", search, scan,
+			(double)stats.bytes_allocated / nb_values);
+		start = clock();
+		for (unsigned int i=0; i< MAP_LOOKUPS; ++i) {
+			unsigned int nb_operations = 0;
+			found += block_skiplist_search(b, keys[i * 7919ULL % nb_values], &nb_operations);
+		}
+		search = elapsed_ns(start);
+		start = clock();
+		block_skiplist_map(b, sum_values, &sum);
+		scan = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / nb_values;
+		printf("\tblocks,   %s : %.0f ns, %.1f ns, %.1f bytes\n", inserted ? "inserts" : "bulk   ", search, scan,
+			(double)block_skiplist_bytes(b) / nb_values);
+		printf("%llu keys found, sum %lld\n", found, sum);
+		skiplist_delete(&l);
+		block_skiplist_delete(&b);
+	}
+	free(keys);
+}
+
+/** Aggregations.
+ Time AGGREGATE_REPEAT sums of the nb_values keys of a skiplist through skiplist_map, through skiplist_map_batch with each
+ kernel, and with each kernel through skiplist_aggregate_range and block_skiplist_aggregate_range.
+ */
+#define AGGREGATE_REPEAT 10
+
+void aggregate_batch(const int *values, size_t n, void* environment){
+	keys_aggregate(values, n, (KeyAggregate*)environment);
+}
+
+void bench_aggregate(unsigned int nb_values){
+	int *keys = malloc(nb_values*sizeof(int));
+	for (unsigned int i=0; i< nb_values; ++i) {
+		keys[i] = (int)growth_key(i);
+	}
+	SkipList* l = skiplist_build_from_array(keys, nb_values, 0);
+	BlockSkipList* b = block_skiplist_build_from_array(keys, nb_values, 0);
+	free(keys);
+	printf("Aggregate %u keys, ns per key\n", nb_values);
+	long long int sum = 0;
+	clock_t start = clock();
+	for (int r = 0; r < AGGREGATE_REPEAT; ++r) {
+		skiplist_map(l, sum_values, &sum);
+	}
+	printf("\tskiplist_map                    : %.2f\n", (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / AGGREGATE_REPEAT / nb_values);
+	KeyKernel selected = keys_kernel();
+	for (KeyKernel kernel = KEY_KERNEL_SCALAR; kernel <= KEY_KERNEL_AVX2; ++kernel) {
+		if (!keys_set_kernel(kernel)) {
+			continue;
+		}
+		const char *methods[] = {"skiplist_map_batch", "skiplist_aggregate_range", "block_skiplist_aggregate_range"};
+		for (int method = 0; method < 3; ++method) {
+			KeyAggregate a = keys_aggregate_init();
+			start = clock();
+			for (int r = 0; r < AGGREGATE_REPEAT; ++r) {
+				if (method == 0) {
+					skiplist_map_batch(l, aggregate_batch, &a);
+				} else if (method == 1) {
+					skiplist_aggregate_range(l, INT_MIN, INT_MAX, &a);
+				} else {
+					block_skiplist_aggregate_range(b, INT_MIN, INT_MAX, &a);
+				}
+			}
+			printf("\t%-31s : %.2f (%s)\n", methods[method],
+				(double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / AGGREGATE_REPEAT / nb_values, keys_kernel_name(kernel));
+			sum += a.sum;
+		}
+	}
+	keys_set_kernel(selected);
+	printf("checksum %lld\n", sum);
+	skiplist_delete(&l);
+	block_skiplist_delete(&b);
+}
+
+/** Aggregations.
+ Aggregate the whole skiplist built from test_files/construct_num.txt and the window between its first and third quartiles,
+ check them against a block skiplist and a scan, check the batches of skiplist_map_batch and check each kernel
+ supported by the processor against the scalar kernel on runs of KERNEL_CHECK_KEYS random keys.
+ */
+#define KERNEL_CHECK_KEYS 300
+
+void print_aggregate(const char *name, KeyAggregate a){
+	printf("%s : %lu values, sum %lld, min %d, max %d\n", name, (unsigned long)a.count, a.sum, a.min, a.max);
+}
+
+bool same_aggregate(KeyAggregate a, KeyAggregate b){
+	return a.count == b.count && a.sum == b.sum && (a.count == 0 || (a.min == b.min && a.max == b.max));
+}
+
+void store_batch(const int *values, size_t n, void* environment){
+	int **cursor = (int**)environment;
+	for (size_t i = 0; i < n; ++i) {
+		*(*cursor)++ = values[i];
+	}
+}
+
+bool check_kernels(void){
+	int keys[KERNEL_CHECK_KEYS];
+	int sorted[KERNEL_CHECK_KEYS];
+	uint64_t state = 1;
+	for (unsigned int i = 0; i < KERNEL_CHECK_KEYS; ++i) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		keys[i] = i % 50 == 7 ? INT_MIN : i % 50 == 11 ? INT_MAX : (int)(state >> 32);
+		sorted[i] = keys[i];
+	}
+	qsort(sorted, KERNEL_CHECK_KEYS, sizeof(int), compare_values);
+	KeyKernel selected = keys_kernel();
+	bool agree = true;
+	for (KeyKernel kernel = KEY_KERNEL_SSE4; kernel <= KEY_KERNEL_AVX2; ++kernel) {
+		for (size_t n = 0; keys_set_kernel(kernel) && n <= KERNEL_CHECK_KEYS; ++n) {
+			int lo = keys[n % KERNEL_CHECK_KEYS] / 2;
+			int hi = keys[(n * 7) % KERNEL_CHECK_KEYS];
+			int key = sorted[(n * 13) % KERNEL_CHECK_KEYS];
+			// searched keys are the sorted keys, their predecessors and their successors
+			if (n % 3 == 0 && key > INT_MIN) {
+				--key;
+			} else if (n % 3 == 2 && key < INT_MAX) {
+				++key;
+			}
+			KeyAggregate a = keys_aggregate_init();
+			keys_aggregate(keys, n, &a);
+			size_t count = keys_count_range(keys, n, lo, hi);
+			size_t position = keys_lower_bound(sorted, n, key);
+			keys_set_kernel(KEY_KERNEL_SCALAR);
+			KeyAggregate reference = keys_aggregate_init();
+			keys_aggregate(keys, n, &reference);
+			agree = agree && same_aggregate(a, reference) && count == keys_count_range(keys, n, lo, hi)
+				&& position == keys_lower_bound(sorted, n, key);
+		}
+	}
+	keys_set_kernel(selected);
+	return agree;
+}
+
+void test_aggregate(int num){
+	SkipList* l = buildlist(num);
+	unsigned int size = skiplist_size(l);
+	int *values = malloc((size + 1)*sizeof(int));
+	int *batches = malloc((size + 1)*sizeof(int));
+	int *cursor = values;
+	skiplist_map(l, store_value, &cursor);
+	cursor = batches;
+	skiplist_map_batch(l, store_batch, &cursor);
+	BlockSkipList* b = block_skiplist_build_from_array(values, size, 0);
+	Window range = {skiplist_at(l, size/4), skiplist_at(l, 3*size/4), 0, 0};
+	skiplist_range_map(l, range.lo, range.hi, count_in_window, &range);
+	KeyAggregate all = keys_aggregate_init();
+	KeyAggregate window = keys_aggregate_init();
+	KeyAggregate block_all = keys_aggregate_init();
+	KeyAggregate block_window = keys_aggregate_init();
+	skiplist_aggregate_range(l, INT_MIN, INT_MAX, &all);
+	skiplist_aggregate_range(l, range.lo, range.hi, &window);
+	block_skiplist_aggregate_range(b, INT_MIN, INT_MAX, &block_all);
+	block_skiplist_aggregate_range(b, range.lo, range.hi, &block_window);
+	printf("Skiplist (%u)\n", size);
+	// INT_MAX is out of [INT_MIN, INT_MAX)
+	print_aggregate("Aggregate of [INT_MIN, INT_MAX)", all);
+	printf("Window [%d, %d)", range.lo, range.hi);
+	print_aggregate("", window);
+	printf("\tSame as the window scan : %s\n", window.count == range.count && window.sum == range.sum ? "yes" : "no");
+	printf("\tSame aggregates with a block skiplist : %s\n",
+		same_aggregate(all, block_all) && same_aggregate(window, block_window) ? "yes" : "no");
+	printf("\tSame values by batches : %s\n", memcmp(values, batches, size*sizeof(int)) == 0 ? "yes" : "no");
+	printf("\tKernels agree with the scalar kernel : %s\n", check_kernels() ? "yes" : "no");
+	free(values);
+	free(batches);
+	skiplist_delete(&l);
+	block_skiplist_delete(&b);
+}
+
+/** Erase at cursor.
+ Sweep the list built from test_files/construct_num.txt with an iterator on the stack, erasing the values of
+ test_files/remove_num.txt, and print it as in test_remove. Then erase one value out of two by a backward sweep
+ and ERASE_SEEKS values found by seek, and check the list against the same removes by skiplist_remove. Check that a
+ list created with more than SKIPLIST_MAX_LEVEL levels is swept by an iterator on the stack.
+ */
+#define ERASE_SEEKS 100
+
+bool contains_value(const int *sorted, unsigned int n, int value) {
+	return bsearch(&value, sorted, n, sizeof(int), compare_values) != NULL;
+}
+
+void test_erase(int num){
+	unsigned int nb_removes;
+	int *removes = read_values("remove", num, &nb_removes);
+	qsort(removes, nb_removes, sizeof(int), compare_values);
+	SkipList* l = buildlist(num);
+	SkipListIterator it;
+	for (skiplist_iterator_init(&it, l, FORWARD_ITERATOR); !skiplist_iterator_end(&it); ) {
+		if (contains_value(removes, nb_removes, skiplist_iterator_value(&it))) {
+			skiplist_iterator_erase(&it);
+		} else {
+			skiplist_iterator_next(&it);
+		}
+	}
+	printf("Skiplist (%i)\n", skiplist_size((const SkipList*) l));
+	iterate_on_skiplist(l, BACKWARD_ITERATOR, print_list, stdout);
+	bool consistent = check_positions(l);
+
+	SkipList* reference = buildlist(num);
+	for (unsigned int i=0; i< nb_removes; ++i) {
+		reference = skiplist_remove(reference, removes[i]);
+	}
+	bool odd = false;
+	for (skiplist_iterator_init(&it, l, BACKWARD_ITERATOR); !skiplist_iterator_end(&it); odd = !odd) {
+		if (odd) {
+			reference = skiplist_remove(reference, skiplist_iterator_value(&it));
+			skiplist_iterator_erase(&it);
+		} else {
+			skiplist_iterator_next(&it);
+		}
+	}
+	consistent = consistent && same_content(l, reference) && check_positions(l);
+	for (unsigned int i=0; i< ERASE_SEEKS && skiplist_size(l) > 0; ++i) {
+		int value = skiplist_at(l, skiplist_size(l) / 2);
+		skiplist_iterator_seek(skiplist_iterator_init(&it, l, FORWARD_ITERATOR), value);
+		skiplist_iterator_erase(&it);
+		reference = skiplist_remove(reference, value);
+	}
+	consistent = consistent && same_content(l, reference) && check_positions(l);
+	// a list asking for more levels than a stack iterator holds gets SKIPLIST_MAX_LEVEL levels
+	SkipList* high = skiplist_create(2*SKIPLIST_MAX_LEVEL);
+	for (unsigned int i=0; i< nb_removes; ++i) {
+		high = skiplist_insert(high, removes[i]);
+	}
+	SkipListStats stats;
+	skiplist_stats(high, &stats);
+	consistent = consistent && stats.max_level == SKIPLIST_MAX_LEVEL;
+	for (skiplist_iterator_init(&it, high, FORWARD_ITERATOR); !skiplist_iterator_end(&it); ) {
+		skiplist_iterator_erase(&it);
+	}
+	consistent = consistent && skiplist_size(high) == 0;
+	skiplist_delete(&high);
+	if (!consistent) {
+		printf("Inconsistent erase\n");
+	}
+	free(removes);
+	skiplist_delete(&l);
+	skiplist_delete(&reference);
+}
+
+/** Sweep and evict.
+ Remove one key out of two from a list of nb_values keys by a sweep with an allocated iterator and skiplist_remove,
+ then by a sweep with an iterator on the stack and skiplist_iterator_erase.
+ */
+void bench_evict(unsigned int nb_values){
+	int *keys = malloc(nb_values*sizeof(int));
+	for (unsigned int i=0; i< nb_values; ++i) {
+		keys[i] = (int)growth_key(i);
+	}
+	printf("Evict the odd keys of %u keys\n", nb_values);
+	SkipList* l = skiplist_build_from_array(keys, nb_values, 0);
+	clock_t start = clock();
+	SkipListIterator* e = skiplist_iterator_create(l, FORWARD_ITERATOR);
+	for (e = skiplist_iterator_begin(e); !skiplist_iterator_end(e); ) {
+		int value = skiplist_iterator_value(e);
+		e = skiplist_iterator_next(e);
+		if (value & 1) {
+			l = skiplist_remove(l, value);
+		}
+	}
+	skiplist_iterator_delete(&e);
+	printf("\tskiplist_remove          : %.1f ns per key, %u left\n",
+		(double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / nb_values, skiplist_size(l));
+	skiplist_delete(&l);
+	l = skiplist_build_from_array(keys, nb_values, 0);
+	start = clock();
+	SkipListIterator it;
+	for (skiplist_iterator_init(&it, l, FORWARD_ITERATOR); !skiplist_iterator_end(&it); ) {
+		if (skiplist_iterator_value(&it) & 1) {
+			skiplist_iterator_erase(&it);
+		} else {
+			skiplist_iterator_next(&it);
+		}
+	}
+	printf("\tskiplist_iterator_erase  : %.1f ns per key, %u left\n",
+		(double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / nb_values, skiplist_size(l));
+	skiplist_delete(&l);
+	free(keys);
+}
+
+/** Snapshots.
+ Save the list built from test_files/construct_num.txt to test_files/snapshot_num.skl, load it back and map it.
+ The loaded list must have the same values and the same towers, the mapped list must answer as the list,
+ and a truncated image must be rejected.
+ */
+bool same_shape(SkipList* a, SkipList* b){
+	SkipListStats sa;
+	SkipListStats sb;
+	skiplist_stats(a, &sa);
+	skiplist_stats(b, &sb);
+	return sa.size == sb.size && sa.level == sb.level && sa.max_search_path == sb.max_search_path
+		&& sa.average_search_path == sb.average_search_path
+		&& memcmp(sa.nodes_per_level, sb.nodes_per_level, sizeof(sa.nodes_per_level)) == 0;
+}
+
+bool check_mapped(SkipList* l, MappedSkipList* m){
+	unsigned int size = skiplist_size(l);
+	bool consistent = mapped_skiplist_size(m) == size;
+	for (unsigned int i=0; i< size && consistent; ++i) {
+		int value = skiplist_at(l, i);
+		unsigned int nb_operations = 0;
+		consistent = mapped_skiplist_at(m, i) == value && mapped_skiplist_rank(m, value) == (int)i
+			&& mapped_skiplist_search(m, value, &nb_operations);
+		if (value < INT_MAX) {
+			// the successor of a value is found in the mapped list as in the list
+			consistent = consistent && mapped_skiplist_search(m, value + 1, &nb_operations) == skiplist_search(l, value + 1, &nb_operations);
+		}
+	}
+	int *values = malloc((size + 1)*sizeof(int));
+	int *mapped = malloc((size + 1)*sizeof(int));
+	int *cursor = values;
+	skiplist_map(l, store_value, &cursor);
+	cursor = mapped;
+	mapped_skiplist_map(m, store_value, &cursor);
+	consistent = consistent && memcmp(values, mapped, size*sizeof(int)) == 0;
+	KeyAggregate all = keys_aggregate_init();
+	KeyAggregate mapped_all = keys_aggregate_init();
+	skiplist_aggregate_range(l, INT_MIN, INT_MAX, &all);
+	mapped_skiplist_aggregate_range(m, INT_MIN, INT_MAX, &mapped_all);
+	free(values);
+	free(mapped);
+	return consistent && same_aggregate(all, mapped_all);
+}
+
+/** Rewrite a file without its last byte.
+ */
+bool drop_last_byte(const char *filename) {
+	MappedFile file;
+	if (!map_file(filename, &file) || file.size == 0) {
+		return false;
+	}
+	char *content = malloc(file.size);
+	size_t size = file.size - 1;
+	memcpy(content, file.data, size);
+	unmap_file(&file);
+	FILE *output = fopen(filename, "wb");
+	bool written = output != NULL && fwrite(content, 1, size, output) == size;
+	written = output != NULL && fclose(output) == 0 && written;
+	free(content);
+	return written;
+}
+
+void test_snapshot(int num){
+	SkipList* l = buildlist(num);
+	char *filename = gettestfile("snapshot", num, "skl");
+	bool saved = skiplist_save(l, filename);
+	SkipList* c = skiplist_load(filename);
+	if (c == NULL) {
+		printf("Unable to load file %s\n", filename);
+		exit (1);
+	}
+	printf("Skiplist (%i)\n", skiplist_size(c));
+	skiplist_map((const SkipList*) c, print_list, stdout);
+	printf("\n\tSaved : %s\n", saved ? "yes" : "no");
+	printf("\tSame values and towers after load : %s\n", same_content(l, c) && same_shape(l, c) ? "yes" : "no");
+	printf("\tPositions after load : %s\n", check_positions(c) ? "yes" : "no");
+	MappedSkipList* m = skiplist_open_mapped(filename);
+	printf("\tMapped list answers as the list : %s\n", m != NULL && check_mapped(l, m) ? "yes" : "no");
+	if (m != NULL) {
+		mapped_skiplist_close(&m);
+	}
+	// dropping the last height leaves an image too short for its number of values
+	bool truncated = drop_last_byte(filename);
+	SkipList* t = skiplist_load(filename);
+	m = skiplist_open_mapped(filename);
+	printf("\tTruncated image rejected : %s\n", truncated && t == NULL && m == NULL ? "yes" : "no");
+	remove(filename);
+	free(filename);
+	skiplist_delete(&l);
+	skiplist_delete(&c);
+}
+
+/** Snapshot loading.
+ Time the bulk construction of a list of nb_values keys, its save, its load and the opening of its mapped image,
+ then MAP_LOOKUPS searches in the list and in the mapped image.
+ */
+void bench_snapshot(unsigned int nb_values){
+	int *keys = malloc(nb_values*sizeof(int));
+	for (unsigned int i=0; i< nb_values; ++i) {
+		keys[i] = (int)growth_key(i);
+	}
+	char *filename = gettestfile("snapshot", 0, "skl");
+	printf("Snapshot of %u keys\n", nb_values);
+	clock_t start = clock();
+	SkipList* l = skiplist_build_from_array(keys, nb_values, 0);
+	printf("\tbuild from values : %.2f ms\n", (double)(clock() - start) / CLOCKS_PER_SEC * 1e3);
+	start = clock();
+	bool saved = skiplist_save(l, filename);
+	printf("\tsave              : %.2f ms\n", (double)(clock() - start) / CLOCKS_PER_SEC * 1e3);
+	start = clock();
+	SkipList* c = skiplist_load(filename);
+	printf("\tload              : %.2f ms\n", (double)(clock() - start) / CLOCKS_PER_SEC * 1e3);
+	start = clock();
+	MappedSkipList* m = skiplist_open_mapped(filename);
+	printf("\topen mapped       : %.3f ms\n", (double)(clock() - start) / CLOCKS_PER_SEC * 1e3);
+	if (!saved || c == NULL || m == NULL) {
+		printf("Unable to save or load file %s\n", filename);
+		exit (1);
+	}
+	unsigned long long int found = 0;
+	start = clock();
+	for (unsigned int i=0; i< MAP_LOOKUPS; ++i) {
+		unsigned int nb_operations = 0;
+		found += skiplist_search(c, keys[i * 7919ULL % nb_values], &nb_operations);
+	}
+	printf("\tsearch in the loaded list : %.0f ns\n", elapsed_ns(start));
+	start = clock();
+	for (unsigned int i=0; i< MAP_LOOKUPS; ++i) {
+		unsigned int nb_operations = 0;
+		found += mapped_skiplist_search(m, keys[i * 7919ULL % nb_values], &nb_operations);
+	}
+	printf("\tsearch in the mapped image : %.0f ns\n", elapsed_ns(start));
+	printf("%llu keys found\n", found);
+	mapped_skiplist_close(&m);
+	remove(filename);
+	free(filename);
+	skiplist_delete(&l);
+	skiplist_delete(&c);
+	free(keys);
+}
+
+/** Hinted inserts.
+ Construct the skiplist with data read from file test_files/construct_num.txt by inserts through a forward and a
+ backward iterator left on the previous value, and print it as in test_construction. Then check both lists against
+ the list built by skiplist_insert, check an ascending ingest against skiplist_build_from_array, and check inserts
+ hinted by HINT_SEEKS seeks against skiplist_insert.
+ */
+#define HINT_SEEKS 100
+
+bool check_hint_inserts(int num, IteratorDirection direction, SkipList* reference){
+	int nblevels;
+	unsigned int nb_values;
+	int *values = read_construct_values(num, &nblevels, &nb_values);
+	SkipList* l = skiplist_create(nblevels);
+	SkipListIterator it;
+	skiplist_iterator_init(&it, l, direction);
+	for (unsigned int i=0; i< nb_values; ++i) {
+		l = skiplist_insert_hint(l, &it, values[i]);
+	}
+	bool consistent = same_content(l, reference) && same_shape(l, reference) && check_positions(l);
+	free(values);
+	skiplist_delete(&l);
+	return consistent;
+}
+
+void test_hint(int num){
+	SkipList* l = buildlist(num);
+	printf("Skiplist (%i)\n", skiplist_size(l));
+	skiplist_map((const SkipList*) l, print_list, stdout);
+	bool consistent = check_hint_inserts(num, FORWARD_ITERATOR, l) && check_hint_inserts(num, BACKWARD_ITERATOR, l);
+
+	int nblevels;
+	unsigned int nb_values;
+	int *values = read_construct_values(num, &nblevels, &nb_values);
+	qsort(values, nb_values, sizeof(int), compare_values);
+	SkipList* ascending = skiplist_create(nblevels);
+	for (unsigned int i=0; i< nb_values; ++i) {
+		ascending = skiplist_insert(ascending, values[i]);
+	}
+	SkipList* loaded = skiplist_build_from_array(values, nb_values, nblevels);
+	consistent = consistent && same_content(ascending, loaded) && check_positions(ascending);
+
+	SkipListIterator it;
+	for (unsigned int i=0; i< HINT_SEEKS; ++i) {
+		int value = values[(i * 7919u) % nb_values];
+		int inserted = value ^ (int)(i % 8);
+		skiplist_iterator_seek(skiplist_iterator_init(&it, ascending, i & 1 ? FORWARD_ITERATOR : BACKWARD_ITERATOR), value);
+		ascending = skiplist_insert_hint(ascending, &it, inserted);
+		loaded = skiplist_insert(loaded, inserted);
+		consistent = consistent && !skiplist_iterator_end(&it) && skiplist_iterator_value(&it) == inserted;
+	}
+	consistent = consistent && same_content(ascending, loaded) && check_positions(ascending);
+	if (!consistent) {
+		printf("Inconsistent hint inserts\n");
+	}
+	free(values);
+	skiplist_delete(&l);
+	skiplist_delete(&ascending);
+	skiplist_delete(&loaded);
+}
+
+/** Ingest.
+ Insert nb_values ascending keys in an array growing by doubling, in a skiplist by skiplist_insert and by
+ skiplist_insert_hint, then nearly sorted keys, reversed by groups of 8, and a sorted run of one key out of
+ INGEST_SWEEP, spread over a list of the even keys, by skiplist_insert and by skiplist_insert_hint through an
+ iterator left on the previous key.
+ */
+#define INGEST_DISORDER 7
+#define INGEST_SWEEP 10
+
+double ingest_time(SkipList* l, int* keys, unsigned int nb_values, bool hinted){
+	SkipListIterator it;
+	skiplist_iterator_init(&it, l, FORWARD_ITERATOR);
+	clock_t start = clock();
+	for (unsigned int i=0; i< nb_values; ++i) {
+		if (hinted) {
+			l = skiplist_insert_hint(l, &it, keys[i]);
+		} else {
+			l = skiplist_insert(l, keys[i]);
+		}
+	}
+	double time = (double)(clock() - start) / CLOCKS_PER_SEC;
+	skiplist_delete(&l);
+	return time * 1e9 / nb_values;
+}
+
+double sweep_time(int* keys, unsigned int nb_values, bool hinted){
+	unsigned int nb_sweep = nb_values / INGEST_SWEEP;
+	int *sweep = malloc(nb_sweep*sizeof(int));
+	for (unsigned int i=0; i< nb_sweep; ++i) {
+		sweep[i] = keys[i * INGEST_SWEEP] + 1;
+	}
+	double time = ingest_time(skiplist_build_from_array(keys, nb_values, 0), sweep, nb_sweep, hinted);
+	free(sweep);
+	return time;
+}
+
+void bench_ingest(unsigned int nb_values){
+	int *keys = malloc(nb_values*sizeof(int));
+	for (unsigned int i=0; i< nb_values; ++i) {
+		keys[i] = (int)i;
+	}
+	printf("Ingest %u keys\n", nb_values);
+	clock_t start = clock();
+	unsigned int capacity = 1;
+	int *array = malloc(capacity*sizeof(int));
+	for (unsigned int i=0; i< nb_values; ++i) {
+		if (i == capacity) {
+			capacity *= 2;
+			array = realloc(array, capacity*sizeof(int));
+		}
+		array[i] = keys[i];
+	}
+	printf("\tascending, array append        : %.1f ns per key\n",
+		(double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / nb_values);
+	free(array);
+	printf("\tascending, skiplist_insert      : %.1f ns per key\n", ingest_time(skiplist_create(0), keys, nb_values, false));
+	printf("\tascending, skiplist_insert_hint : %.1f ns per key\n", ingest_time(skiplist_create(0), keys, nb_values, true));
+	for (unsigned int i=0; i< nb_values; ++i) {
+		keys[i] = (int)(i ^ INGEST_DISORDER);
+	}
+	printf("\tdisorder, skiplist_insert       : %.1f ns per key\n", ingest_time(skiplist_create(0), keys, nb_values, false));
+	printf("\tdisorder, skiplist_insert_hint  : %.1f ns per key\n", ingest_time(skiplist_create(0), keys, nb_values, true));
+	for (unsigned int i=0; i< nb_values; ++i) {
+		keys[i] = (int)(2 * i);
+	}
+	printf("\tsweep, skiplist_insert          : %.1f ns per key\n", sweep_time(keys, nb_values, false));
+	printf("\tsweep, skiplist_insert_hint     : %.1f ns per key\n", sweep_time(keys, nb_values, true));
+	free(keys);
+}
+
+/** Set algebra.
+ Construct the skiplists with data read from files test_files/construct_num.txt and test_files/remove_num.txt,
+ print their union, intersection and difference, then check them, and the operations in place, against inserts
+ and searches value by value, with the malloc and the arena allocators, and with a list bulk loaded with more than
+ SKIPLIST_MAX_LEVEL levels.
+ */
+SkipList* list_of_values(const int* values, unsigned int nb_values, int nblevels, SkipListAllocator allocator){
+	SkipList* d = skiplist_create_with_allocator(nblevels, allocator);
+	for (unsigned int i=0; i< nb_values; ++i) {
+		d = skiplist_insert(d, values[i]);
+	}
+	return d;
+}
+
+/* a op b value by value : 'u' for the union, 'i' for the intersection and 'd' for the difference. */
+SkipList* naive_set_operation(SkipList* a, SkipList* b, char op){
+	SkipList* d = skiplist_create(0);
+	SkipListIterator it;
+	unsigned int nb_operations = 0;
+	for (skiplist_iterator_init(&it, a, FORWARD_ITERATOR); !skiplist_iterator_end(&it); skiplist_iterator_next(&it)) {
+		int value = skiplist_iterator_value(&it);
+		if (op == 'u' || skiplist_search(b, value, &nb_operations) == (op == 'i')) {
+			d = skiplist_insert(d, value);
+		}
+	}
+	for (skiplist_iterator_init(&it, b, FORWARD_ITERATOR); op == 'u' && !skiplist_iterator_end(&it); skiplist_iterator_next(&it)) {
+		d = skiplist_insert(d, skiplist_iterator_value(&it));
+	}
+	return d;
+}
+
+void print_set(const char *name, SkipList* d){
+	printf("%s (%i)\n", name, skiplist_size(d));
+	skiplist_map((const SkipList*) d, print_list, stdout);
+	printf("\n");
+}
+
+bool check_set_operations(int num, SkipListAllocator allocator_a, SkipListAllocator allocator_b){
+	int nblevels;
+	unsigned int nb_values;
+	unsigned int nb_removes;
+	int *values = read_construct_values(num, &nblevels, &nb_values);
+	int *removes = read_values("remove", num, &nb_removes);
+	SkipList* a = list_of_values(values, nb_values, nblevels, allocator_a);
+	SkipList* b = list_of_values(removes, nb_removes, 0, allocator_b);
+	bool consistent = true;
+	const char operations[] = "uid";
+	for (int k=0; k< 3; ++k) {
+		SkipList* expected = naive_set_operation(a, b, operations[k]);
+		SkipList* merged = operations[k] == 'u' ? skiplist_union(a, b)
+			: operations[k] == 'i' ? skiplist_intersect(a, b) : skiplist_difference(a, b);
+		SkipList* in_place = list_of_values(values, nb_values, nblevels, allocator_a);
+		SkipList* other = list_of_values(removes, nb_removes, 0, allocator_b);
+		if (operations[k] == 'u') {
+			in_place = skiplist_union_with(in_place, other);
+			// the emptied list stays usable
+			consistent = consistent && skiplist_size(other) == 0 && check_positions(skiplist_insert(other, 1));
+		} else if (operations[k] == 'i') {
+			in_place = skiplist_intersect_with(in_place, other);
+		} else {
+			in_place = skiplist_difference_with(in_place, other);
+		}
+		consistent = consistent && same_content(merged, expected) && check_positions(merged)
+			&& same_content(in_place, expected) && check_positions(in_place);
+		skiplist_delete(&expected);
+		skiplist_delete(&merged);
+		skiplist_delete(&in_place);
+		skiplist_delete(&other);
+	}
+	consistent = consistent && check_positions(a) && check_positions(b);
+	skiplist_delete(&a);
+	skiplist_delete(&b);
+	free(values);
+	free(removes);
+	return consistent;
+}
+
+void test_sets(int num){
+	unsigned int nb_removes;
+	SkipList* a = buildlist(num);
+	int *removes = read_values("remove", num, &nb_removes);
+	SkipList* b = list_of_values(removes, nb_removes, 0, MALLOC_ALLOCATOR);
+	SkipList* d = skiplist_union(a, b);
+	print_set("Union", d);
+	skiplist_delete(&d);
+	d = skiplist_intersect(a, b);
+	print_set("Intersection", d);
+	skiplist_delete(&d);
+	d = skiplist_difference(a, b);
+	print_set("Difference", d);
+	skiplist_delete(&d);
+	bool consistent = check_set_operations(num, MALLOC_ALLOCATOR, MALLOC_ALLOCATOR)
+		&& check_set_operations(num, ARENA_ALLOCATOR, MALLOC_ALLOCATOR)
+		&& check_set_operations(num, MALLOC_ALLOCATOR, ARENA_ALLOCATOR);
+	// the towers of a list asking for more than SKIPLIST_MAX_LEVEL levels are linked within SKIPLIST_MAX_LEVEL levels
+	int *sorted = read_values("remove", num, &nb_removes);
+	qsort(sorted, nb_removes, sizeof(int), compare_values);
+	SkipList* high = skiplist_build_from_array(sorted, nb_removes, 2*SKIPLIST_MAX_LEVEL);
+	d = skiplist_union(high, a);
+	SkipList* copy = skiplist_union(a, a);
+	consistent = consistent && same_content(skiplist_union_with(high, copy), d) && check_positions(d);
+	skiplist_delete(&d);
+	skiplist_delete(&copy);
+	skiplist_delete(&high);
+	free(sorted);
+	if (!consistent) {
+		printf("Inconsistent set operations\n");
+	}
+	skiplist_delete(&a);
+	skiplist_delete(&b);
+	free(removes);
+}
+
+/** Merge.
+ Intersect and unite two skiplists of nb_values keys, the even keys and the multiples of 3, value by value and by
+ the set operations, then intersect the even keys with a sparse list of one key out of MERGE_SPARSE.
+ */
+#define MERGE_SPARSE 1000
+
+SkipList* multiples(unsigned int nb_values, int factor){
+	int *keys = calloc(nb_values + 1, sizeof(int));
+	for (unsigned int i=0; i< nb_values; ++i) {
+		keys[i] = (int)i * factor;
+	}
+	SkipList* d = skiplist_build_from_array(keys, nb_values, 0);
+	free(keys);
+	return d;
+}
+
+void bench_merge(unsigned int nb_values){
+	SkipList* even = multiples(nb_values, 2);
+	SkipList* triple = multiples(nb_values, 3);
+	SkipList* sparse = multiples(nb_values / MERGE_SPARSE, 2 * MERGE_SPARSE);
+	printf("Merge two skiplists of %u keys\n", nb_values);
+	const char *names[] = {"union", "intersection", "sparse intersection"};
+	const char operations[] = "uii";
+	SkipList* second[] = {triple, triple, sparse};
+	for (int k=0; k< 3; ++k) {
+		clock_t start = clock();
+		SkipList* d = naive_set_operation(even, second[k], operations[k]);
+		double naive = (double)(clock() - start) / CLOCKS_PER_SEC;
+		unsigned int size = skiplist_size(d);
+		skiplist_delete(&d);
+		start = clock();
+		d = operations[k] == 'u' ? skiplist_union(even, second[k]) : skiplist_intersect(even, second[k]);
+		double merged = (double)(clock() - start) / CLOCKS_PER_SEC;
+		skiplist_delete(&d);
+		printf("\t%-20s : %u values, value by value %.3f s, merged %.3f s\n", names[k], size, naive, merged);
+	}
+	SkipList* copy = skiplist_union(even, triple);
+	clock_t start = clock();
+	skiplist_intersect_with(copy, sparse);
+	printf("\t%-20s : %u values, in place %.3f s\n", names[2], skiplist_size(copy), (double)(clock() - start) / CLOCKS_PER_SEC);
+	skiplist_delete(&copy);
+	SkipList* spliced = multiples(nb_values, 2);
+	start = clock();
+	skiplist_union_with(spliced, triple);
+	printf("\t%-20s : %u values, in place %.3f s\n", names[0], skiplist_size(spliced), (double)(clock() - start) / CLOCKS_PER_SEC);
+	skiplist_delete(&spliced);
+	skiplist_delete(&even);
+	skiplist_delete(&triple);
+	skiplist_delete(&sparse);
+}
+
+/** Split and concatenation.
+ Construct the skiplist with data read from file test_files/construct_num.txt, split it at its median value and print
+ the left part, then the right part in reverse order. Check the splits at SPLIT_KEYS values of the list and
+ their concatenation against the list, with the malloc and the arena allocators, and a concatenation whose
+ right part is higher than the left part allows.
+ */
+#define SPLIT_KEYS 50
+
+bool check_split(SkipList* left, SkipList* right, int key){
+	bool consistent = check_positions(left) && check_positions(right);
+	consistent = consistent && (skiplist_size(left) == 0 || skiplist_at(left, skiplist_size(left) - 1) < key);
+	consistent = consistent && (skiplist_size(right) == 0 || skiplist_at(right, 0) >= key);
+	// the prev links are cut as the next links
+	SkipListIterator it;
+	unsigned int i = skiplist_size(right);
+	for (skiplist_iterator_init(&it, right, BACKWARD_ITERATOR); !skiplist_iterator_end(&it) && consistent; skiplist_iterator_next(&it)) {
+		consistent = i > 0 && skiplist_iterator_value(&it) == skiplist_at(right, --i);
+	}
+	return consistent;
+}
+
+bool check_splits(int num, SkipListAllocator allocator){
+	int nblevels;
+	unsigned int nb_values;
+	int *values = read_construct_values(num, &nblevels, &nb_values);
+	SkipList* reference = list_of_values(values, nb_values, nblevels, allocator);
+	SkipList* l = list_of_values(values, nb_values, nblevels, allocator);
+	unsigned int size = skiplist_size(l);
+	bool consistent = true;
+	for (unsigned int k=0; k<= SPLIT_KEYS && consistent; ++k) {
+		// from below the lowest value to above the highest one
+		int key = k == 0 ? INT_MIN : skiplist_at(reference, (unsigned int)((unsigned long long)(k - 1) * size / SPLIT_KEYS));
+		key = k == SPLIT_KEYS && key < INT_MAX ? key + 1 : key;
+		SkipList* left;
+		SkipList* right;
+		skiplist_split(l, key, &left, &right);
+		consistent = check_split(left, right, key) && skiplist_size(left) + skiplist_size(right) == size;
+		l = skiplist_concat(left, right);
+		consistent = consistent && skiplist_size(right) == 0 && same_content(l, reference) && check_positions(l)
+			&& check_positions(skiplist_insert(right, 0));
+		skiplist_delete(&right);
+	}
+	skiplist_delete(&l);
+	// the right part is higher than the left part allows
+	SkipList* low = skiplist_create_with_allocator(1, allocator);
+	SkipList* high = skiplist_create(0);
+	for (unsigned int i=0; i< nb_values; ++i) {
+		if (values[i] < 0) {
+			low = skiplist_insert(low, values[i]);
+		} else {
+			high = skiplist_insert(high, values[i]);
+		}
+	}
+	low = skiplist_concat(low, high);
+	consistent = consistent && same_content(low, reference) && check_positions(low) && skiplist_size(high) == 0;
+	skiplist_delete(&low);
+	skiplist_delete(&high);
+	skiplist_delete(&reference);
+	free(values);
+	return consistent;
+}
+
+void test_split(int num){
+	SkipList* l = buildlist(num);
+	int key = skiplist_size(l) > 0 ? skiplist_at(l, skiplist_size(l) / 2) : 0;
+	SkipList* left;
+	SkipList* right;
+	skiplist_split(l, key, &left, &right);
+	printf("Left (%i)\n", skiplist_size(left));
+	skiplist_map((const SkipList*) left, print_list, stdout);
+	printf("\nRight (%i)\n", skiplist_size(right));
+	iterate_on_skiplist(right, BACKWARD_ITERATOR, print_list, stdout);
+	printf("\n");
+	bool consistent = check_split(left, right, key) && check_splits(num, MALLOC_ALLOCATOR) && check_splits(num, ARENA_ALLOCATOR);
+	if (!consistent) {
+		printf("Inconsistent split\n");
+	}
+	skiplist_delete(&left);
+	skiplist_delete(&right);
+}
+
+/** Split and concatenate.
+ Move the upper half of a skiplist of nb_values keys to another one and back, by removes and inserts, then by
+ skiplist_split and skiplist_concat, and time SPLIT_KEYS splits and concatenations at random keys.
+ */
+void bench_split(unsigned int nb_values){
+	SkipList* l = multiples(nb_values, 1);
+	int key = (int)(nb_values / 2);
+	printf("Split and concatenate %u keys\n", nb_values);
+	clock_t start = clock();
+	SkipList* upper = skiplist_create(0);
+	for (int value = key; value < (int)nb_values; ++value) {
+		l = skiplist_remove(l, value);
+		upper = skiplist_insert(upper, value);
+	}
+	for (int value = key; value < (int)nb_values; ++value) {
+		upper = skiplist_remove(upper, value);
+		l = skiplist_insert(l, value);
+	}
+	printf("\tremoves and inserts : %.3f s\n", (double)(clock() - start) / CLOCKS_PER_SEC);
+	skiplist_delete(&upper);
+	start = clock();
+	SkipList* left;
+	SkipList* right;
+	skiplist_split(l, key, &left, &right);
+	l = skiplist_concat(left, right);
+	printf("\tsplit and concat    : %.6f s\n", (double)(clock() - start) / CLOCKS_PER_SEC);
+	skiplist_delete(&right);
+	start = clock();
+	for (unsigned int k=0; k< SPLIT_KEYS; ++k) {
+		skiplist_split(l, (int)(growth_key(k) % nb_values), &left, &right);
+		l = skiplist_concat(left, right);
+		skiplist_delete(&right);
+	}
+	printf("\t%d random splits and concats : %.1f us each\n", SPLIT_KEYS,
+		(double)(clock() - start) / CLOCKS_PER_SEC * 1e6 / SPLIT_KEYS);
+	skiplist_delete(&l);
+}
+
+/** Snapshots.
+ Construct the skiplist with data read from file test_files/construct_num.txt, take a snapshot of it and print the
+ snapshot through its iterator while values are removed from and inserted in the list. Check the snapshot, and a
+ second one taken half way, against copies of the list made when they were taken, with the malloc and the arena
+ allocators, while another thread reads them. Check that released snapshots and copies of their handles are refused.
+ */
+#define SNAPSHOT_READS 20
+
+bool check_snapshot(const SkipListSnapshot* s, SkipList* reference){
+	unsigned int size = skiplist_size(reference);
+	unsigned int snapshot_size = 0;
+	bool consistent = skiplist_snapshot_size(s, &snapshot_size) && snapshot_size == size;
+	unsigned int nb_operations = 0;
+	unsigned int i = 0;
+	SkipListSnapshotIterator it;
+	for (skiplist_snapshot_iterator_init(&it, s); !skiplist_snapshot_iterator_end(&it) && consistent; skiplist_snapshot_iterator_next(&it)) {
+		int value = skiplist_snapshot_iterator_value(&it);
+		int at = ~value;
+		bool found = false;
+		consistent = i < size && value == skiplist_at(reference, i) && skiplist_snapshot_at(s, i, &at) && at == value
+			&& skiplist_snapshot_search(s, value, &found, &nb_operations) && found;
+		if (value < INT_MAX) {
+			consistent = consistent && skiplist_snapshot_search(s, value + 1, &found, &nb_operations)
+				&& found == skiplist_search(reference, value + 1, &nb_operations);
+		}
+		++i;
+	}
+	int after = 0;
+	return consistent && i == size && !skiplist_snapshot_at(s, size, &after);
+}
+
+/* Remove the current value of a snapshot iterator from l, remove its successor and insert it back, as the list is
+   scanned. */
+void modify_under_snapshot(SkipList* l, SkipList* expected, int value, unsigned int i){
+	if (i % 3 == 0) {
+		l = skiplist_remove(l, value);
+		expected = skiplist_remove(expected, value);
+	}
+	if (i % 4 == 0 && value < INT_MAX) {
+		l = skiplist_insert(skiplist_remove(l, value + 1), value + 1);
+	}
+	if (i % 2 == 0 && value < INT_MAX) {
+		l = skiplist_insert(l, value + 1);
+		expected = skiplist_insert(expected, value + 1);
+	}
+}
+
+/* Reader of a snapshot in another thread than the writer of its list. */
+typedef struct s_SnapshotReader {
+	const SkipListSnapshot* snapshot;
+	SkipList* reference;
+	bool consistent;
+} SnapshotReader;
+
+void *read_snapshot(void *environment){
+	SnapshotReader *reader = environment;
+	reader->consistent = true;
+	for (int k = 0; k < SNAPSHOT_READS && reader->consistent; ++k) {
+		reader->consistent = check_snapshot(reader->snapshot, reader->reference);
+	}
+	return NULL;
+}
+
+bool check_snapshots(int num, SkipListAllocator allocator){
+	int nblevels;
+	unsigned int nb_values;
+	int *values = read_construct_values(num, &nblevels, &nb_values);
+	SkipList* l = list_of_values(values, nb_values, nblevels, allocator);
+	SkipList* expected = list_of_values(values, nb_values, nblevels, MALLOC_ALLOCATOR);
+	SkipList* first = list_of_values(values, nb_values, nblevels, MALLOC_ALLOCATOR);
+	SkipListSnapshot s = skiplist_snapshot(l);
+	SnapshotReader reader = {&s, first, true};
+	pthread_t thread;
+	pthread_create(&thread, NULL, read_snapshot, &reader);
+	SkipListSnapshot half = {NULL, 0};
+	SkipList* second = NULL;
+	unsigned int i = 0;
+	SkipListSnapshotIterator it;
+	for (skiplist_snapshot_iterator_init(&it, &s); !skiplist_snapshot_iterator_end(&it); skiplist_snapshot_iterator_next(&it)) {
+		if (i == nb_values / 2) {
+			half = skiplist_snapshot(l);
+			second = skiplist_union(expected, expected);
+		}
+		modify_under_snapshot(l, expected, skiplist_snapshot_iterator_value(&it), i++);
+	}
+	pthread_join(thread, NULL);
+	bool consistent = reader.consistent && check_snapshot(&s, first) && (!second || check_snapshot(&half, second));
+	SkipListSnapshot stale = s;
+	consistent = consistent && skiplist_snapshot_release(&s) && !skiplist_snapshot_release(&s)
+		&& !skiplist_snapshot_release(&stale) && !skiplist_snapshot_size(&stale, &i)
+		&& !skiplist_snapshot_iterator_init(&it, &stale) && skiplist_snapshot_iterator_end(&it);
+	consistent = consistent && (!second || check_snapshot(&half, second)) && same_content(l, expected) && check_positions(l);
+	if (second) {
+		// the iterator ends when its snapshot is released
+		skiplist_snapshot_iterator_init(&it, &half);
+		consistent = consistent && skiplist_snapshot_release(&half) && !skiplist_snapshot_iterator_next(&it)
+			&& skiplist_snapshot_iterator_end(&it);
+		skiplist_delete(&second);
+	}
+	// the list goes on without live snapshot, its in-place operations moving the values one by one
+	SkipList* left;
+	SkipList* right;
+	int key = skiplist_size(l) > 0 ? skiplist_at(l, skiplist_size(l) / 2) : 0;
+	skiplist_split(l, key, &left, &right);
+	l = skiplist_concat(left, right);
+	consistent = consistent && same_content(l, expected) && check_positions(l) && skiplist_size(right) == 0;
+	skiplist_delete(&right);
+	// a list deleted with a live snapshot is freed with it
+	s = skiplist_snapshot(l);
+	l = skiplist_remove_range(l, INT_MIN, INT_MAX);
+	skiplist_delete(&l);
+	consistent = consistent && l == NULL && check_snapshot(&s, expected) && skiplist_snapshot_release(&s);
+	skiplist_delete(&expected);
+	skiplist_delete(&first);
+	free(values);
+	return consistent;
+}
+
+void test_snapshot_view(int num){
+	SkipList* l = buildlist(num);
+	SkipList* expected = buildlist(num);
+	SkipListSnapshot s = skiplist_snapshot(l);
+	printf("Skiplist (%i)\n", skiplist_size(expected));
+	unsigned int i = 0;
+	SkipListSnapshotIterator it;
+	for (skiplist_snapshot_iterator_init(&it, &s); !skiplist_snapshot_iterator_end(&it); skiplist_snapshot_iterator_next(&it)) {
+		print_list(skiplist_snapshot_iterator_value(&it), stdout);
+		modify_under_snapshot(l, expected, skiplist_snapshot_iterator_value(&it), i++);
+	}
+	skiplist_snapshot_release(&s);
+	bool consistent = same_content(l, expected) && check_snapshots(num, MALLOC_ALLOCATOR) && check_snapshots(num, ARENA_ALLOCATOR);
+	if (!consistent) {
+		printf("Inconsistent snapshot\n");
+	}
+	skiplist_delete(&l);
+	skiplist_delete(&expected);
+}
+
+/** Snapshot.
+ Scan a skiplist of nb_values keys in a copy of it and in a snapshot, taken in O(1), while one key out of two is
+ removed from the list and its successor inserted, by the same thread, then by another thread than the scan.
+ */
+typedef struct s_SnapshotWriter {
+	SkipList* list;
+	unsigned int nb_values;
+} SnapshotWriter;
+
+void *move_even_keys(void *environment){
+	SnapshotWriter *writer = environment;
+	for (unsigned int value = 0; value < writer->nb_values; value += 2) {
+		writer->list = skiplist_insert(skiplist_remove(writer->list, (int)value), (int)value + 1);
+	}
+	return NULL;
+}
+
+double elapsed_since(const struct timespec *start){
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+void bench_snapshot_scan(unsigned int nb_values){
+	SkipList* l = multiples(nb_values, 2);
+	printf("Scan %u keys under writes\n", nb_values);
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	SkipList* copy = skiplist_union(l, l);
+	double taken = elapsed_since(&start);
+	SkipListIterator copy_it;
+	unsigned int i = 0;
+	for (skiplist_iterator_init(&copy_it, copy, FORWARD_ITERATOR); !skiplist_iterator_end(&copy_it); skiplist_iterator_next(&copy_it)) {
+		int value = skiplist_iterator_value(&copy_it);
+		if (i++ % 2 == 0) {
+			l = skiplist_insert(skiplist_remove(l, value), value + 1);
+		}
+	}
+	printf("\tcopy                : taken in %.6f s, scanned in %.3f s\n", taken, elapsed_since(&start) - taken);
+	skiplist_delete(&copy);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	SkipListSnapshot s = skiplist_snapshot(l);
+	taken = elapsed_since(&start);
+	SkipListSnapshotIterator it;
+	i = 0;
+	for (skiplist_snapshot_iterator_init(&it, &s); !skiplist_snapshot_iterator_end(&it); skiplist_snapshot_iterator_next(&it)) {
+		int value = skiplist_snapshot_iterator_value(&it);
+		if (i++ % 2 == 0) {
+			l = skiplist_insert(skiplist_remove(l, value), value - 1);
+		}
+	}
+	printf("\tsnapshot            : taken in %.6f s, scanned in %.3f s\n", taken, elapsed_since(&start) - taken);
+	skiplist_snapshot_release(&s);
+	// the keys are even again : another thread moves them while the snapshot is scanned
+	SnapshotWriter writer = {l, 2*nb_values};
+	s = skiplist_snapshot(l);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pthread_t thread;
+	pthread_create(&thread, NULL, move_even_keys, &writer);
+	unsigned int scanned = 0;
+	for (skiplist_snapshot_iterator_init(&it, &s); !skiplist_snapshot_iterator_end(&it); skiplist_snapshot_iterator_next(&it)) {
+		++scanned;
+	}
+	double scan = elapsed_since(&start);
+	pthread_join(thread, NULL);
+	printf("\tsnapshot, 2 threads : scanned %u keys in %.3f s, writes done in %.3f s\n", scanned, scan, elapsed_since(&start));
+	skiplist_snapshot_release(&s);
+	l = writer.list;
+	skiplist_delete(&l);
+}
+
+/** Duplicated inserts.
+ Insert DUPLICATE_INSERTS keys in a list of DUPLICATE_KEYS keys, one in ten being new, with skiplist_insert,
+ with a search before each insert and with skiplist_insert_ex.
+ */
+#define DUPLICATE_KEYS 100000
+#define DUPLICATE_INSERTS 2000000
+
+void bench_duplicates(int levels){
+	const char *methods[] = {"skiplist_insert       ", "search then insert    ", "skiplist_insert_ex    "};
+	printf("Insert %d keys, 90%% of them already among %d (%d levels)\n", DUPLICATE_INSERTS, DUPLICATE_KEYS, levels);
+	for (int method = 0; method < 3; ++method) {
+		SkipList* l = skiplist_create(levels);
+		for (unsigned int i=0; i< DUPLICATE_KEYS; ++i) {
+			l = skiplist_insert(l, (int)growth_key(i));
+		}
+		unsigned int nb_new = 0;
+		clock_t start = clock();
+		for (unsigned int i=0; i< DUPLICATE_INSERTS; ++i) {
+			int key = (int)growth_key(i % 10 == 9 ? DUPLICATE_KEYS + i : (unsigned int)(i * 7919ULL % DUPLICATE_KEYS));
+			if (method == 0) {
+				l = skiplist_insert(l, key);
+			} else if (method == 1) {
+				unsigned int nb_operations = 0;
+				if (!skiplist_search(l, key, &nb_operations)) {
+					l = skiplist_insert(l, key);
+					++nb_new;
+				}
+			} else {
+				bool inserted;
+				l = skiplist_insert_ex(l, key, &inserted);
+				nb_new += inserted;
+			}
+		}
+		double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / DUPLICATE_INSERTS;
+		printf("\t%s : %.0f ns per insert, size %u", methods[method], elapsed, skiplist_size(l));
+		if (method > 0) {
+			printf(", %u new keys", nb_new);
+		}
+		printf("\n");
+		skiplist_delete(&l);
+	}
+}
+
+/** Loading of the test files.
+ Read each text file of the given number by fscanf and by the parser of load_text_values, write it to its binary form
+ and load it back. A binary file is mapped without copy : its values are read only when used.
+ */
+double elapsed_ms(clock_t start){
+	return (double)(clock() - start) / CLOCKS_PER_SEC * 1e3;
+}
+
+/* parse_int reads what fscanf("%d") reads, and refuses what it refuses or would overflow. */
+bool check_parse_int(void){
+	const struct {const char *text; bool parsed; int value;} cases[] = {
+		{" \n\t42 ", true, 42}, {"-7", true, -7}, {"+5", true, 5}, {"2147483647", true, INT_MAX},
+		{"-2147483648", true, INT_MIN}, {"", false, 0}, {" \n", false, 0}, {"-", false, 0}, {"- 3", false, 0},
+		{"x1", false, 0}, {"2147483648", false, 0}, {"-2147483649", false, 0}, {"99999999999", false, 0}
+	};
+	bool same = true;
+	for (unsigned int i = 0; i < sizeof(cases)/sizeof(cases[0]); ++i) {
+		const char *cursor = cases[i].text;
+		int value = 0;
+		bool parsed = parse_int(&cursor, cases[i].text + strlen(cases[i].text), &value);
+		same = same && parsed == cases[i].parsed && (!parsed || value == cases[i].value);
+	}
+	return same;
+}
+
+void convert_test_files(int num){
+	if (!check_parse_int()) {
+		printf("The parser of load_text_values disagrees with fscanf\n");
+	}
+	const char *actions[] = {"construct", "search", "remove"};
+	for (int a = 0; a < 3; ++a) {
+		char *filename = gettestfilename(actions[a], num);
+		FILE *input = fopen(filename, "r");
+		if (input == NULL) {
+			free(filename);
+			continue;
+		}
+		bool construct = a == 0;
+		clock_t start = clock();
+		int nblevels = construct ? (int) read_uint(input) : 0;
+		unsigned int nb_values = read_uint(input);
+		int *values = malloc((nb_values + 1)*sizeof(int));
+		for (unsigned int i=0; i< nb_values; ++i) {
+			values[i] = read_int(input);
+		}
+		double scanned = elapsed_ms(start);
+		fclose(input);
+		TestValues t;
+		start = clock();
+		load_text_values(filename, construct, &t);
+		double parsed = elapsed_ms(start);
+		bool same = t.nb_values == nb_values && t.nblevels == nblevels && memcmp(t.values, values, nb_values*sizeof(int)) == 0;
+		release_test_values(&t);
+		char *binary = gettestfile(actions[a], num, "bin");
+		write_binary_values(binary, nblevels, values, nb_values, file_size(filename));
+		start = clock();
+		load_binary_values(binary, &t);
+		double loaded = elapsed_ms(start);
+		same = same && t.nb_values == nb_values && memcmp(t.values, values, nb_values*sizeof(int)) == 0;
+		release_test_values(&t);
+		printf("%s_%d : %u values, fscanf %.3f ms, parser %.3f ms, binary %.3f ms%s\n", actions[a], num, nb_values,
+			scanned, parsed, loaded, same ? "" : ", DIFFERENT VALUES");
+		free(binary);
+		free(filename);
+		free(values);
+	}
+}
+
+/** Distribution of the heights.
+ Draw DISTRIBUTION_DRAWS heights with each generator and compare the frequencies to the law of rng_get_value() by a
+ chi-squared test at the 0.1% level. Heights whose expected count is too low to be tested are merged with the highest one.
+ */
+#define DISTRIBUTION_DRAWS (1 << 20)
+
+const char *generator_names[] = {"lcg", "ctz"};
+
+bool check_distribution(RNGGenerator generator, int levels){
+	RNG rng = rng_initialize_generator(0x7FFFFFFF, levels, generator);
+	unsigned int max_value = rng_upper_bound(&rng);
+	unsigned int *counts = calloc(max_value + 1, sizeof(unsigned int));
+	for (int i = 0; i < DISTRIBUTION_DRAWS; ++i) {
+		unsigned int value = rng_get_value(&rng);
+		if (value > max_value) {
+			free(counts);
+			return false;
+		}
+		++counts[value];
+	}
+	double chi2 = 0;
+	int classes = 0;
+	double expected_left = DISTRIBUTION_DRAWS;
+	double observed_left = DISTRIBUTION_DRAWS;
+	for (unsigned int i = 0; i < max_value && expected_left / 2 >= 5; ++i) {
+		double expected = expected_left / 2;
+		chi2 += (counts[i] - expected) * (counts[i] - expected) / expected;
+		expected_left -= expected;
+		observed_left -= counts[i];
+		++classes;
+	}
+	chi2 += (observed_left - expected_left) * (observed_left - expected_left) / expected_left;
+	free(counts);
+	if (classes == 0) {
+		return true;
+	}
+	// Wilson-Hilferty approximation of the 99.9% quantile of the chi-squared law with classes degrees of freedom
+	double k = classes;
+	double threshold = k * pow(1 - 2 / (9 * k) + 3.09 * sqrt(2 / (9 * k)), 3);
+	return chi2 < threshold;
+}
+
+void test_distribution(int num){
+	int levels;
+	unsigned int nb_values;
+	int *values = read_construct_values(num, &levels, &nb_values);
+	free(values);
+	for (RNGGenerator generator = RNG_LCG; generator <= RNG_CTZ; ++generator) {
+		printf("Generator %s (%d levels) : %s\n", generator_names[generator], levels,
+			check_distribution(generator, levels) ? "distribution OK" : "distribution KO");
+	}
+}
+
+/** Cost of the heights.
+ Time HEIGHT_DRAWS draws of each generator.
+ */
+#define HEIGHT_DRAWS 50000000
+
+void bench_heights(int num){
+	int levels;
+	unsigned int nb_values;
+	int *values = read_construct_values(num, &levels, &nb_values);
+	free(values);
+	printf("Draw %d heights (%d levels)\n", HEIGHT_DRAWS, levels);
+	for (RNGGenerator generator = RNG_LCG; generator <= RNG_CTZ; ++generator) {
+		RNG rng = rng_initialize_generator(0x7FFFFFFF, levels, generator);
+		unsigned long long int sum = 0;
+		clock_t start = clock();
+		for (int i = 0; i < HEIGHT_DRAWS; ++i) {
+			sum += rng_get_value(&rng);
+		}
+		double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+		printf("\t%s : %.2f ns per height, mean height %.4f\n", generator_names[generator],
+			elapsed * 1e9 / HEIGHT_DRAWS, 1 + (double)sum / HEIGHT_DRAWS);
+	}
+}
+
+/** Concurrent skiplist.
+ Threads insert a share of the values of test_files/construct_num.txt while searching the others, then
+ remove a share of the values of test_files/remove_num.txt. The result is printed as in test_remove.
+ */
+#define CONCURRENT_THREADS 4
+
+typedef struct s_ConcurrentTask {
+	ConcurrentSkipList* list;
+	const int *values;
+	unsigned int nb_values;
+	int thread;
+	bool insert;
+} ConcurrentTask;
+
+void *concurrent_task(void *environment){
+	ConcurrentTask *task = (ConcurrentTask*)environment;
+	for (unsigned int i=0; i< task->nb_values; ++i) {
+		if (i % CONCURRENT_THREADS == (unsigned int)task->thread) {
+			if (task->insert) {
+				concurrent_skiplist_insert(task->list, task->values[i]);
+			} else {
+				concurrent_skiplist_remove(task->list, task->values[i]);
+			}
+		} else {
+			unsigned int nb_operations = 0;
+			concurrent_skiplist_search(task->list, task->values[i], &nb_operations);
+		}
+	}
+	return NULL;
+}
+
+void run_concurrent_tasks(ConcurrentSkipList* l, const int *values, unsigned int nb_values, bool insert){
+	pthread_t threads[CONCURRENT_THREADS];
+	ConcurrentTask tasks[CONCURRENT_THREADS];
+	for (int t = 0; t < CONCURRENT_THREADS; ++t) {
+		tasks[t] = (ConcurrentTask){l, values, nb_values, t, insert};
+		pthread_create(&threads[t], NULL, concurrent_task, &tasks[t]);
+	}
+	for (int t = 0; t < CONCURRENT_THREADS; ++t) {
+		pthread_join(threads[t], NULL);
+	}
+}
+
+/* More lists than a process has thread keys are live at once, and a list created after a deleted one does not take
+   over its thread records. */
+#define CONCURRENT_LISTS 2048
+
+bool check_concurrent_lists(const int *values, unsigned int nb_values, int levels, unsigned int size){
+	ConcurrentSkipList** lists = malloc(CONCURRENT_LISTS*sizeof(ConcurrentSkipList*));
+	for (int i = 0; i < CONCURRENT_LISTS; ++i) {
+		lists[i] = concurrent_skiplist_create(levels);
+		concurrent_skiplist_insert(lists[i], values[(unsigned int)i % nb_values]);
+	}
+	for (int i = 0; i < CONCURRENT_LISTS; i += CONCURRENT_LISTS / 8) {
+		concurrent_skiplist_delete(&lists[i]);
+		lists[i] = concurrent_skiplist_create(levels);
+		run_concurrent_tasks(lists[i], values, nb_values, true);
+	}
+	bool consistent = true;
+	for (int i = 0; i < CONCURRENT_LISTS; ++i) {
+		consistent = consistent && concurrent_skiplist_size(lists[i]) == (i % (CONCURRENT_LISTS / 8) ? 1 : size);
+		concurrent_skiplist_delete(&lists[i]);
+	}
+	free(lists);
+	return consistent;
+}
+
+void test_concurrent(int num){
+	int levels;
+	unsigned int nb_values;
+	int *values = read_construct_values(num, &levels, &nb_values);
+	ConcurrentSkipList* l = concurrent_skiplist_create(levels);
+	run_concurrent_tasks(l, values, nb_values, true);
+	if (!check_concurrent_lists(values, nb_values, levels, concurrent_skiplist_size(l))) {
+		printf("Inconsistent concurrent lists\n");
+	}
+	free(values);
+	values = read_values("remove", num, &nb_values);
+	run_concurrent_tasks(l, values, nb_values, false);
+	free(values);
+	unsigned int size = concurrent_skiplist_size(l);
+	int *content = malloc((size + 1)*sizeof(int));
+	int *cursor = content;
+	concurrent_skiplist_map(l, store_value, &cursor);
+	printf("Skiplist (%u)\n", size);
+	while (cursor != content) {
+		print_list(*--cursor, stdout);
+	}
+	free(content);
+	concurrent_skiplist_delete(&l);
+}
+
+/** Benchmark of the concurrent skiplist.
+ Each thread runs BENCH_OPERATIONS operations on the values of test_files/search_num.txt, a given percentage
+ of them being inserts or removes, on a list initialized with test_files/construct_num.txt.
+ */
+#define BENCH_OPERATIONS 400000
+
+typedef struct s_BenchTask {
+	ConcurrentSkipList* concurrent;
+	SkipList* locked;
+	pthread_mutex_t *lock;
+	const int *values;
+	unsigned int nb_values;
+	int thread;
+	int write_percent;
+} BenchTask;
+
+void *bench_task(void *environment){
+	BenchTask *task = (BenchTask*)environment;
+	unsigned int i = (unsigned int)task->thread * 7919;
+	for (int op = 0; op < BENCH_OPERATIONS; ++op, ++i) {
+		int value = task->values[i % task->nb_values];
+		int kind = op % 100 < task->write_percent ? 1 + op % 2 : 0;
+		unsigned int nb_operations = 0;
+		if (task->concurrent) {
+			if (kind == 0) {
+				concurrent_skiplist_search(task->concurrent, value, &nb_operations);
+			} else if (kind == 1) {
+				concurrent_skiplist_insert(task->concurrent, value);
+			} else {
+				concurrent_skiplist_remove(task->concurrent, value);
+			}
+		} else {
+			pthread_mutex_lock(task->lock);
+			if (kind == 0) {
+				skiplist_search(task->locked, value, &nb_operations);
+			} else if (kind == 1) {
+				task->locked = skiplist_insert(task->locked, value);
+			} else {
+				task->locked = skiplist_remove(task->locked, value);
+			}
+			pthread_mutex_unlock(task->lock);
+		}
+	}
+	return NULL;
+}
+
+double bench_threads(bool concurrent, int nb_threads, int write_percent, int num){
+	int levels;
+	unsigned int nb_values;
+	int *values = read_construct_values(num, &levels, &nb_values);
+	ConcurrentSkipList* c = NULL;
+	SkipList* l = NULL;
+	if (concurrent) {
+		c = concurrent_skiplist_create(levels);
+		for (unsigned int i=0; i< nb_values; ++i) {
+			concurrent_skiplist_insert(c, values[i]);
+		}
+	} else {
+		l = skiplist_build_from_array(values, nb_values, levels);
+	}
+	free(values);
+	values = read_values("search", num, &nb_values);
+	pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	pthread_t *threads = malloc(nb_threads*sizeof(pthread_t));
+	BenchTask *tasks = malloc(nb_threads*sizeof(BenchTask));
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int t = 0; t < nb_threads; ++t) {
+		tasks[t] = (BenchTask){c, l, &lock, values, nb_values, t, write_percent};
+		pthread_create(&threads[t], NULL, bench_task, &tasks[t]);
+	}
+	for (int t = 0; t < nb_threads; ++t) {
+		pthread_join(threads[t], NULL);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+	if (concurrent) {
+		concurrent_skiplist_delete(&c);
+	} else {
+		l = tasks[0].locked;
+		skiplist_delete(&l);
+	}
+	free(threads);
+	free(tasks);
+	free(values);
+	return (double)nb_threads * BENCH_OPERATIONS / elapsed;
+}
+
+void bench_concurrent(int num, int max_threads){
+	const int write_percents[] = {0, 10, 50};
+	printf("Operations per second (%d operations per thread)\n", BENCH_OPERATIONS);
+	printf("threads\twrites\tconcurrent\tglobal mutex\n");
+	for (int nb_threads = 1; nb_threads <= max_threads; nb_threads = (nb_threads*2 > max_threads && nb_threads < max_threads) ? max_threads : nb_threads*2) {
+		for (int w = 0; w < 3; ++w) {
+			printf("%d\t%d%%\t%.0f\t%.0f\n", nb_threads, write_percents[w],
+				bench_threads(true, nb_threads, write_percents[w], num), bench_threads(false, nb_threads, write_percents[w], num));
+		}
+	}
+}
+
+/** Function you can use to generate dataset for testing.
+ */
+void generate(int nbvalues);
+
+
+int main(int argc, const char *argv[]){
+	if (argc < 3) {
+		usage(argv[0]);
+		return 1;
+	}
+	switch (argv[1][1]) {
+		case 'c' :
+			test_construction(atoi(argv[2]));
+			break;
+		case 's' :
+			test_search(atoi(argv[2]));
+			break;
+		case 'i' :
+			test_search_iterator(atoi(argv[2]));
+			break;
+		case 'r' :
+			test_remove(atoi(argv[2]));
+			break;
+		case 'E' :
+			test_erase(atoi(argv[2]));
+			break;
+		case 'a' :
+			test_rank(atoi(argv[2]));
+			break;
+		case 'f' :
+			test_search_batch(atoi(argv[2]));
+			break;
+		case 'P' :
+			test_prefetch(atoi(argv[2]));
+			break;
+		case 'w' :
+			test_range(atoi(argv[2]));
+			break;
+		case 'e' :
+			test_adaptive(atoi(argv[2]));
+			break;
+		case 'l' :
+			bench_growth(atoi(argv[2]), argc > 3 ? (unsigned int)atol(argv[3]) : 10000000);
+			break;
+		case 'd' :
+			test_distribution(atoi(argv[2]));
+			break;
+		case 'h' :
+			bench_heights(atoi(argv[2]));
+			break;
+		case 'p' :
+			test_stats(atoi(argv[2]));
+			break;
+		case 'k' :
+			test_map(atoi(argv[2]));
+			break;
+		case 'j' :
+			test_block(atoi(argv[2]));
+			break;
+		case 'y' :
+			bench_block(argc > 3 ? (unsigned int)atol(argv[3]) : 1000000);
+			break;
+		case 'q' :
+			test_aggregate(atoi(argv[2]));
+			break;
+		case 'z' :
+			bench_aggregate(argc > 3 ? (unsigned int)atol(argv[3]) : 1000000);
+			break;
+		case 'S' :
+			test_snapshot(atoi(argv[2]));
+			break;
+		case 'L' :
+			bench_snapshot(argc > 3 ? (unsigned int)atol(argv[3]) : 1000000);
+			break;
+		case 'v' :
+			bench_map(atoi(argv[2]), argc > 3 ? (unsigned int)atol(argv[3]) : 1000000);
+			break;
+		case 'n' :
+			bench_duplicates(atoi(argv[2]));
+			break;
+		case 'x' :
+			convert_test_files(atoi(argv[2]));
+			break;
+		case 'u' :
+			test_concurrent(atoi(argv[2]));
+			break;
+		case 't' :
+			bench_concurrent(atoi(argv[2]), argc > 3 ? atoi(argv[3]) : (int)sysconf(_SC_NPROCESSORS_ONLN));
+			break;
+		case 'o' :
+			test_complexity(atoi(argv[2]));
+			break;
+		case 'b' :
+			bench_build(atoi(argv[2]));
+			break;
+		case 'm' :
+			bench_allocators(atoi(argv[2]));
+			break;
+		case 'H' :
+			test_hint(atoi(argv[2]));
+			break;
+		case 'A' :
+			bench_ingest(argc > 3 ? (unsigned int)atol(argv[3]) : 10000000);
+			break;
+		case 'U' :
+			test_sets(atoi(argv[2]));
+			break;
+		case 'G' :
+			bench_merge(argc > 3 ? (unsigned int)atol(argv[3]) : 1000000);
+			break;
+		case 'C' :
+			test_split(atoi(argv[2]));
+			break;
+		case 'K' :
+			bench_split(argc > 3 ? (unsigned int)atol(argv[3]) : 1000000);
+			break;
+		case 'N' :
+			test_snapshot_view(atoi(argv[2]));
+			break;
+		case 'W' :
+			bench_snapshot_scan(argc > 3 ? (unsigned int)atol(argv[3]) : 1000000);
+			break;
+		case 'V' :
+			bench_evict(argc > 3 ? (unsigned int)atol(argv[3]) : 1000000);
 			break;
 		case 'g' :
 			generate(atoi(argv[2]));
@@ -291,23 +2882,30 @@ void generate(int nbvalues){
 	FILE *output;
 	int depth;
 	int maxvalue;
+	int *values = malloc((nbvalues + 1)*sizeof(int));
 	output = fopen("construct.txt", "w");
 	srand(nbvalues);
 	depth = rand()%16;
 	maxvalue = rand()%10 * nbvalues;
 	fprintf(output, "%d\n%d\n", depth, nbvalues);
 	for (int i=0; i< nbvalues; ++i) {
-		fprintf(output, "%d\n", rand()%maxvalue);
+		values[i] = rand()%maxvalue;
+		fprintf(output, "%d\n", values[i]);
 	}
 	fclose(output);
+	write_binary_values("construct.bin", depth, values, (unsigned int)nbvalues, file_size("construct.txt"));
 	output = fopen("search.txt", "w");
 	srand(rand());
 	nbvalues *= depth/4;
+	values = realloc(values, (nbvalues + 1)*sizeof(int));
 	fprintf(output, "%d\n", nbvalues);
 	for (int i=0; i< nbvalues; ++i) {
-		fprintf(output, "%d\n", rand()%maxvalue);
+		values[i] = rand()%maxvalue;
+		fprintf(output, "%d\n", values[i]);
 	}
 	fclose(output);
+	write_binary_values("search.bin", 0, values, (unsigned int)nbvalues, file_size("search.txt"));
+	free(values);
 }
 
 
@@ -93,9 +93,386 @@ function test_remove {
     fi
 }
 
+function test_complexity {
+    if [ -x $BASE/$COMMAND ]
+    then
+    rm -f $TESTFILES/result_complexity_$1.txt
+#    echo "Running " $BASE/$COMMAND -o $1
+	$BASE/$COMMAND -o $1 > $TESTFILES/result_complexity_$1.txt  2>/dev/null
+	DIFF=`diff -b -E $TESTFILES/result_complexity_$1.txt $TESTFILES/references/result_complexity_$1.txt`
+	if [ $? -eq 0 ]
+	then
+		RET=0
+	else
+#		echo "Erreur  : " $DIFF
+		RET=1
+	fi
+	rm -f $TESTFILES/result_complexity_$1.txt
+    else
+	echo "Command $BASE/$COMMAND not found"
+	RET=2
+    fi
+}
+
+function test_rank {
+    if [ -x $BASE/$COMMAND ]
+    then
+    rm -f $TESTFILES/result_rank_$1.txt
+#    echo "Running " $BASE/$COMMAND -a $1
+	$BASE/$COMMAND -a $1 > $TESTFILES/result_rank_$1.txt  2>/dev/null
+	DIFF=`diff -b -E $TESTFILES/result_rank_$1.txt $TESTFILES/references/result_rank_$1.txt`
+	if [ $? -eq 0 ]
+	then
+		RET=0
+	else
+#		echo "Erreur  : " $DIFF
+		RET=1
+	fi
+	rm -f $TESTFILES/result_rank_$1.txt
+    else
+	echo "Command $BASE/$COMMAND not found"
+	RET=2
+    fi
+}
+
+function test_batch {
+    if [ -x $BASE/$COMMAND ]
+    then
+    rm -f $TESTFILES/result_batch_$1.txt
+#    echo "Running " $BASE/$COMMAND -f $1
+	$BASE/$COMMAND -f $1 > $TESTFILES/result_batch_$1.txt  2>/dev/null
+	DIFF=`diff -b -E $TESTFILES/result_batch_$1.txt $TESTFILES/references/result_batch_$1.txt`
+	if [ $? -eq 0 ]
+	then
+		RET=0
+	else
+#		echo "Erreur  : " $DIFF
+		RET=1
+	fi
+	rm -f $TESTFILES/result_batch_$1.txt
+    else
+	echo "Command $BASE/$COMMAND not found"
+	RET=2
+    fi
+}
+
+function test_range {
+    if [ -x $BASE/$COMMAND ]
+    then
+    rm -f $TESTFILES/result_range_$1.txt
+#    echo "Running " $BASE/$COMMAND -w $1
+	$BASE/$COMMAND -w $1 > $TESTFILES/result_range_$1.txt  2>/dev/null
+	DIFF=`diff -b -E $TESTFILES/result_range_$1.txt $TESTFILES/references/result_range_$1.txt`
+	if [ $? -eq 0 ]
+	then
+		RET=0
+	else
+#		echo "Erreur  : " $DIFF
+		RET=1
+	fi
+	rm -f $TESTFILES/result_range_$1.txt
+    else
+	echo "Command $BASE/$COMMAND not found"
+	RET=2
+    fi
+}
+
+function test_concurrent {
+    if [ -x $BASE/$COMMAND ]
+    then
+    rm -f $TESTFILES/result_concurrent_$1.txt
+#    echo "Running " $BASE/$COMMAND -u $1
+	$BASE/$COMMAND -u $1 > $TESTFILES/result_concurrent_$1.txt  2>/dev/null
+	DIFF=`diff -b -E $TESTFILES/result_concurrent_$1.txt $TESTFILES/references/result_remove_$1.txt`
+	if [ $? -eq 0 ]
+	then
+		RET=0
+	else
+#		echo "Erreur  : " $DIFF
+		RET=1
+	fi
+	rm -f $TESTFILES/result_concurrent_$1.txt
+    else
+	echo "Command $BASE/$COMMAND not found"
+	RET=2
+    fi
+}
+
+function test_distribution {
+    if [ -x $BASE/$COMMAND ]
+    then
+    rm -f $TESTFILES/result_distribution_$1.txt
+#    echo "Running " $BASE/$COMMAND -d $1
+	$BASE/$COMMAND -d $1 > $TESTFILES/result_distribution_$1.txt  2>/dev/null
+	DIFF=`diff -b -E $TESTFILES/result_distribution_$1.txt $TESTFILES/references/result_distribution_$1.txt`
+	if [ $? -eq 0 ]
+	then
+		RET=0
+	else
+#		echo "Erreur  : " $DIFF
+		RET=1
+	fi
+	rm -f $TESTFILES/result_distribution_$1.txt
+    else
+	echo "Command $BASE/$COMMAND not found"
+	RET=2
+    fi
+}
+
+function test_adaptive {
+    if [ -x $BASE/$COMMAND ]
+    then
+    rm -f $TESTFILES/result_adaptive_$1.txt
+#    echo "Running " $BASE/$COMMAND -e $1
+	$BASE/$COMMAND -e $1 > $TESTFILES/result_adaptive_$1.txt  2>/dev/null
+	DIFF=`diff -b -E $TESTFILES/result_adaptive_$1.txt $TESTFILES/references/result_adaptive_$1.txt`
+	if [ $? -eq 0 ]
+	then
+		RET=0
+	else
+#		echo "Erreur  : " $DIFF
+		RET=1
+	fi
+	rm -f $TESTFILES/result_adaptive_$1.txt
+    else
+	echo "Command $BASE/$COMMAND not found"
+	RET=2
+    fi
+}
+
+function test_map {
+    if [ -x $BASE/$COMMAND ]
+    then
+    rm -f $TESTFILES/result_map_$1.txt
+#    echo "Running " $BASE/$COMMAND -k $1
+	$BASE/$COMMAND -k $1 > $TESTFILES/result_map_$1.txt  2>/dev/null
+	DIFF=`diff -b -E $TESTFILES/result_map_$1.txt $TESTFILES/references/result_remove_$1.txt`
+	if [ $? -eq 0 ]
+	then
+		RET=0
+	else
+#		echo "Erreur  : " $DIFF
+		RET=1
+	fi
+	rm -f $TESTFILES/result_map_$1.txt
+    else
+	echo "Command $BASE/$COMMAND not found"
+	RET=2
+    fi
+}
+
+function test_stats {
+    if [ -x $BASE/$COMMAND ]
+    then
+    rm -f $TESTFILES/result_stats_$1.txt
+#    echo "Running " $BASE/$COMMAND -p $1
+	$BASE/$COMMAND -p $1 > $TESTFILES/result_stats_$1.txt  2>/dev/null
+	DIFF=`diff -b -E $TESTFILES/result_stats_$1.txt $TESTFILES/references/result_stats_$1.txt`
+	if [ $? -eq 0 ]
+	then
+		RET=0
+	else
+#		echo "Erreur  : " $DIFF
+		RET=1
+	fi
+	rm -f $TESTFILES/result_stats_$1.txt
+    else
+	echo "Command $BASE/$COMMAND not found"
+	RET=2
+    fi
+}
+
+function test_block {
+    if [ -x $BASE/$COMMAND ]
+    then
+    rm -f $TESTFILES/result_block_$1.txt
+#    echo "Running " $BASE/$COMMAND -j $1
+	$BASE/$COMMAND -j $1 > $TESTFILES/result_block_$1.txt  2>/dev/null
+	DIFF=`diff -b -E $TESTFILES/result_block_$1.txt $TESTFILES/references/result_remove_$1.txt`
+	if [ $? -eq 0 ]
+	then
+		RET=0
+	else
+#		echo "Erreur  : " $DIFF
+		RET=1
+	fi
+	rm -f $TESTFILES/result_block_$1.txt
+    else
+	echo "Command $BASE/$COMMAND not found"
+	RET=2
+    fi
+}
+
+function test_aggregate {
+    if [ -x $BASE/$COMMAND ]
+    then
+    rm -f $TESTFILES/result_aggregate_$1.txt
+#    echo "Running " $BASE/$COMMAND -q $1
+	$BASE/$COMMAND -q $1 > $TESTFILES/result_aggregate_$1.txt  2>/dev/null
+	DIFF=`diff -b -E $TESTFILES/result_aggregate_$1.txt $TESTFILES/references/result_aggregate_$1.txt`
+	if [ $? -eq 0 ]
+	then
+		RET=0
+	else
+#		echo "Erreur  : " $DIFF
+		RET=1
+	fi
+	rm -f $TESTFILES/result_aggregate_$1.txt
+    else
+	echo "Command $BASE/$COMMAND not found"
+	RET=2
+    fi
+}
+
+function test_snapshot {
+    if [ -x $BASE/$COMMAND ]
+    then
+    rm -f $TESTFILES/result_snapshot_$1.txt
+#    echo "Running " $BASE/$COMMAND -S $1
+	$BASE/$COMMAND -S $1 > $TESTFILES/result_snapshot_$1.txt  2>/dev/null
+	DIFF=`diff -b -E $TESTFILES/result_snapshot_$1.txt $TESTFILES/references/result_snapshot_$1.txt`
+	if [ $? -eq 0 ]
+	then
+		RET=0
+	else
+#		echo "Erreur  : " $DIFF
+		RET=1
+	fi
+	rm -f $TESTFILES/result_snapshot_$1.txt
+    else
+	echo "Command $BASE/$COMMAND not found"
+	RET=2
+    fi
+}
+
+function test_prefetch {
+    if [ -x $BASE/$COMMAND ]
+    then
+    rm -f $TESTFILES/result_prefetch_$1.txt
+#    echo "Running " $BASE/$COMMAND -P $1
+	$BASE/$COMMAND -P $1 > $TESTFILES/result_prefetch_$1.txt  2>/dev/null
+	DIFF=`diff -b -E $TESTFILES/result_prefetch_$1.txt $TESTFILES/references/result_prefetch_$1.txt`
+	if [ $? -eq 0 ]
+	then
+		RET=0
+	else
+#		echo "Erreur  : " $DIFF
+		RET=1
+	fi
+	rm -f $TESTFILES/result_prefetch_$1.txt
+    else
+	echo "Command $BASE/$COMMAND not found"
+	RET=2
+    fi
+}
+
+function test_erase {
+    if [ -x $BASE/$COMMAND ]
+    then
+    rm -f $TESTFILES/result_erase_$1.txt
+#    echo "Running " $BASE/$COMMAND -E $1
+	$BASE/$COMMAND -E $1 > $TESTFILES/result_erase_$1.txt  2>/dev/null
+	DIFF=`diff -b -E $TESTFILES/result_erase_$1.txt $TESTFILES/references/result_remove_$1.txt`
+	if [ $? -eq 0 ]
+	then
+		RET=0
+	else
+#		echo "Erreur  : " $DIFF
+		RET=1
+	fi
+	rm -f $TESTFILES/result_erase_$1.txt
+    else
+	echo "Command $BASE/$COMMAND not found"
+	RET=2
+    fi
+}
+
+function test_hint {
+    if [ -x $BASE/$COMMAND ]
+    then
+    rm -f $TESTFILES/result_hint_$1.txt
+#    echo "Running " $BASE/$COMMAND -H $1
+	$BASE/$COMMAND -H $1 > $TESTFILES/result_hint_$1.txt  2>/dev/null
+	DIFF=`diff -b -E $TESTFILES/result_hint_$1.txt $TESTFILES/references/result_construct_$1.txt`
+	if [ $? -eq 0 ]
+	then
+		RET=0
+	else
+#		echo "Erreur  : " $DIFF
+		RET=1
+	fi
+	rm -f $TESTFILES/result_hint_$1.txt
+    else
+	echo "Command $BASE/$COMMAND not found"
+	RET=2
+    fi
+}
+
+function test_sets {
+    if [ -x $BASE/$COMMAND ]
+    then
+    rm -f $TESTFILES/result_sets_$1.txt
+#    echo "Running " $BASE/$COMMAND -U $1
+	$BASE/$COMMAND -U $1 > $TESTFILES/result_sets_$1.txt  2>/dev/null
+	DIFF=`diff -b -E $TESTFILES/result_sets_$1.txt $TESTFILES/references/result_sets_$1.txt`
+	if [ $? -eq 0 ]
+	then
+		RET=0
+	else
+#		echo "Erreur  : " $DIFF
+		RET=1
+	fi
+	rm -f $TESTFILES/result_sets_$1.txt
+    else
+	echo "Command $BASE/$COMMAND not found"
+	RET=2
+    fi
+}
+
+function test_split {
+    if [ -x $BASE/$COMMAND ]
+    then
+    rm -f $TESTFILES/result_split_$1.txt
+#    echo "Running " $BASE/$COMMAND -C $1
+	$BASE/$COMMAND -C $1 > $TESTFILES/result_split_$1.txt  2>/dev/null
+	DIFF=`diff -b -E $TESTFILES/result_split_$1.txt $TESTFILES/references/result_split_$1.txt`
+	if [ $? -eq 0 ]
+	then
+		RET=0
+	else
+#		echo "Erreur  : " $DIFF
+		RET=1
+	fi
+	rm -f $TESTFILES/result_split_$1.txt
+    else
+	echo "Command $BASE/$COMMAND not found"
+	RET=2
+    fi
+}
+
+function test_snapshot_view {
+    if [ -x $BASE/$COMMAND ]
+    then
+    rm -f $TESTFILES/result_snapshot_view_$1.txt
+#    echo "Running " $BASE/$COMMAND -N $1
+	$BASE/$COMMAND -N $1 > $TESTFILES/result_snapshot_view_$1.txt  2>/dev/null
+	DIFF=`diff -b -E $TESTFILES/result_snapshot_view_$1.txt $TESTFILES/references/result_construct_$1.txt`
+	if [ $? -eq 0 ]
+	then
+		RET=0
+	else
+#		echo "Erreur  : " $DIFF
+		RET=1
+	fi
+	rm -f $TESTFILES/result_snapshot_view_$1.txt
+    else
+	echo "Command $BASE/$COMMAND not found"
+	RET=2
+    fi
+}
 
 function runtest {
- for i in $(seq 1 1 $2)
+ for i in $2
  do
 	test_$1 $i
 	[ $RET -eq 0 ] && printf "%-12s [${ok}OK${wipe}]\n" "$1 ($i)" 
@@ -105,8 +482,26 @@ function runtest {
 
 echo Executing $COMMAND in directory $PWD
 
-runtest construction 4;
-runtest search 4;
-runtest iterator 4;
-runtest remove 4;
+runtest construction "1 2 3 4 6";
+runtest search "1 2 3 4 6";
+runtest iterator "1 2 3 4 6";
+runtest remove "1 2 3 4 6";
+runtest complexity "1 2 3 4 6";
+runtest rank "1 2 3 4 6";
+runtest batch "1 2 3 4 6";
+runtest range "1 2 3 4 6";
+runtest concurrent "1 2 3 4 6";
+runtest distribution "1 2 3 4 6";
+runtest adaptive "1 2 3 4 6";
+runtest map "1 2 3 4 6";
+runtest stats "1 2 3 4 6";
+runtest block "1 2 3 4 6";
+runtest aggregate "1 2 3 4 6";
+runtest snapshot "1 2 3 4 6";
+runtest prefetch "1 2 3 4 6";
+runtest erase "1 2 3 4 6";
+runtest hint "1 2 3 4 6";
+runtest sets "1 2 3 4 6";
+runtest split "1 2 3 4 6";
+runtest snapshot_view "1 2 3 4 6";
 exit 0